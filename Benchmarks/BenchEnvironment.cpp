@@ -0,0 +1,18 @@
+/*
+ // Copyright (c) 2015-2018 Pierre Guillot.
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+// The environment of the plugins depends on JUCE, so the benchmarks
+// only define the methods used by the Pd sources with default values.
+
+#include "../Source/PluginEnvironment.h"
+
+const char* CamomileEnvironment::getPluginNameUTF8() { return "Camomile"; }
+const char* CamomileEnvironment::getPluginManufacturerUTF8() { return "Camomile"; }
+const char* CamomileEnvironment::getPluginDescriptionUTF8() { return "Camomile"; }
+unsigned int CamomileEnvironment::getPluginCode() { return 0; }
+uint32_t CamomileEnvironment::getDefaultForegroundColor() { return 0xff000000; }
+uint32_t CamomileEnvironment::getDefaultBackgroundColor() { return 0xffffffff; }
+uint32_t CamomileEnvironment::getTransparentColor() { return 0x00000000; }
@@ -0,0 +1,139 @@
+/*
+ // Copyright (c) 2015-2018 Pierre Guillot.
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+// Measures how the processing of the instances scales with the number of threads.
+// Each thread owns an instance that performs ticks of the DSP like the audio thread of
+// a plugin: the instance is locked once per tick, receives a few messages and performs
+// its DSP. With locks that are local to the instances, the total number of ticks per
+// second grows linearly with the number of threads, up to the number of cores.
+//
+// usage: bench_instances [max threads] [seconds per run] [messages per tick]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "PdInstance.hpp"
+
+namespace
+{
+    constexpr int nchannels = 2;
+    constexpr int blocksize = 64;
+    constexpr double samplerate = 44100.0;
+    
+    class BenchInstance : public pd::Instance
+    {
+    public:
+        BenchInstance() : pd::Instance("camomile")
+        {
+            prepareDSP(nchannels, nchannels, samplerate, blocksize);
+            openPatch(CAMOMILE_BENCHMARKS_PATCHES, "instances.pd");
+            startDSP();
+            m_inputs.assign(nchannels * blocksize, 0.f);
+            m_outputs.assign(nchannels * blocksize, 0.f);
+            for(int i = 0; i < nchannels; ++i)
+            {
+                m_ins.push_back(m_inputs.data() + i * blocksize);
+                m_outs.push_back(m_outputs.data() + i * blocksize);
+            }
+        }
+        
+        ~BenchInstance()
+        {
+            releaseDSP();
+            closePatch();
+        }
+        
+        void tick(const int nmessages)
+        {
+            beginTick();
+            for(int i = 0; i < nmessages; ++i)
+            {
+                sendFloat("bench", 220.f + static_cast<float>(i));
+            }
+            performDSP(m_ins.data(), m_outs.data(), nchannels, nchannels, blocksize);
+            endTick();
+            processMessages();
+        }
+        
+    private:
+        std::vector<float>          m_inputs;
+        std::vector<float>          m_outputs;
+        std::vector<float const*>   m_ins;
+        std::vector<float*>         m_outs;
+    };
+    
+    //! @brief Runs the instances on one thread each and returns the total number of ticks per second.
+    double run(std::vector<std::unique_ptr<BenchInstance>>& instances, const double seconds, const int nmessages)
+    {
+        std::atomic<bool> start {false};
+        std::atomic<bool> stop {false};
+        std::vector<size_t> ticks(instances.size(), 0);
+        std::vector<std::thread> threads;
+        for(size_t i = 0; i < instances.size(); ++i)
+        {
+            threads.emplace_back([&, i]() {
+                while(!start.load()) { std::this_thread::yield(); }
+                size_t count = 0;
+                while(!stop.load(std::memory_order_relaxed))
+                {
+                    instances[i]->tick(nmessages);
+                    ++count;
+                }
+                ticks[i] = count;
+            });
+        }
+        auto const begin = std::chrono::steady_clock::now();
+        start.store(true);
+        std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+        stop.store(true);
+        for(auto& thread : threads)
+        {
+            thread.join();
+        }
+        const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        size_t total = 0;
+        for(auto const count : ticks)
+        {
+            total += count;
+        }
+        return static_cast<double>(total) / elapsed;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const int hardware = static_cast<int>(std::max(std::thread::hardware_concurrency(), 1u));
+    const int maxthreads = argc > 1 ? std::max(std::atoi(argv[1]), 1) : hardware;
+    const double seconds = argc > 2 ? std::max(std::atof(argv[2]), 0.1) : 2.0;
+    const int nmessages = argc > 3 ? std::max(std::atoi(argv[3]), 0) : 8;
+    const double realtime = samplerate / blocksize;
+    
+    std::printf("cores: %d, seconds per run: %.1f, messages per tick: %d\n", hardware, seconds, nmessages);
+    std::printf("%8s %16s %16s %12s %12s\n", "threads", "ticks/s", "ticks/s/thread", "realtime", "efficiency");
+    double reference = 0.0;
+    std::vector<std::unique_ptr<BenchInstance>> instances;
+    for(int nthreads = 1; nthreads <= maxthreads; ++nthreads)
+    {
+        while(static_cast<int>(instances.size()) < nthreads)
+        {
+            instances.push_back(std::make_unique<BenchInstance>());
+        }
+        const double total = run(instances, seconds, nmessages);
+        if(nthreads == 1)
+        {
+            reference = total;
+        }
+        // The efficiency is the ratio of the total throughput to the linear scaling of one thread.
+        std::printf("%8d %16.0f %16.0f %11.1fx %11.0f%%\n", nthreads, total, total / nthreads,
+                    total / nthreads / realtime, reference > 0.0 ? 100.0 * total / (reference * nthreads) : 0.0);
+    }
+    return 0;
+}
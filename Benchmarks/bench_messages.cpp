@@ -0,0 +1,209 @@
+/*
+ // Copyright (c) 2015-2018 Pierre Guillot.
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+// Measures the messages sent by Pd to the host per second and the allocations per message.
+// The same patch sends the same messages to the receiver of the instance, which queues them
+// in the preallocated slots, and to a receiver that queues them like the instance did before,
+// with a std::string selector and a std::vector of atoms that own std::string symbols.
+//
+// usage: bench_messages [seconds per run] [messages per tick]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+#include "PdInstance.hpp"
+
+extern "C"
+{
+#include <z_libpd.h>
+#include "x_libpd_multi.h"
+}
+
+static std::atomic<size_t> allocations {0};
+
+void* operator new(std::size_t size)
+{
+    ++allocations;
+    if(void* ptr = std::malloc(size ? size : 1))
+    {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+
+namespace
+{
+    //! @brief The receiver of the messages before the preallocated slots.
+    class LegacyReceiver
+    {
+    public:
+        LegacyReceiver()
+        {
+            m_receiver = libpd_multi_receiver_new(this, "legacy",
+                                                  reinterpret_cast<t_libpd_multi_banghook>(bang),
+                                                  reinterpret_cast<t_libpd_multi_floathook>(floating),
+                                                  reinterpret_cast<t_libpd_multi_symbolhook>(symbol),
+                                                  reinterpret_cast<t_libpd_multi_listhook>(list),
+                                                  reinterpret_cast<t_libpd_multi_messagehook>(message));
+        }
+        
+        ~LegacyReceiver()
+        {
+            pd_free(static_cast<t_pd*>(m_receiver));
+        }
+        
+        size_t process()
+        {
+            size_t count = 0;
+            Message mess;
+            while(m_queue.try_dequeue(mess))
+            {
+                if(mess.selector == "bang")
+                    ++count;
+                else if(mess.selector == "float" && !mess.list.empty())
+                    count += mess.list[0].isFloat();
+                else if(mess.selector == "symbol" && !mess.list.empty())
+                    count += mess.list[0].isSymbol();
+                else if(mess.selector == "list")
+                    count += !mess.list.empty();
+                else
+                    count += !mess.selector.empty();
+            }
+            return count;
+        }
+        
+    private:
+        struct Message
+        {
+            std::string selector;
+            std::vector<pd::Atom> list;
+        };
+        
+        static void bang(LegacyReceiver* ptr, const char*)
+        {
+            ptr->m_queue.try_enqueue({std::string("bang")});
+        }
+        
+        static void floating(LegacyReceiver* ptr, const char*, float f)
+        {
+            ptr->m_queue.try_enqueue({std::string("float"), std::vector<pd::Atom>(1, f)});
+        }
+        
+        static void symbol(LegacyReceiver* ptr, const char*, const char *sym)
+        {
+            ptr->m_queue.try_enqueue({std::string("symbol"), std::vector<pd::Atom>(1, std::string(sym))});
+        }
+        
+        static void list(LegacyReceiver* ptr, const char*, int argc, t_atom *argv)
+        {
+            message(ptr, nullptr, "list", argc, argv);
+        }
+        
+        static void message(LegacyReceiver* ptr, const char*, const char *msg, int argc, t_atom *argv)
+        {
+            Message mess{msg, std::vector<pd::Atom>(argc)};
+            for(int i = 0; i < argc; ++i)
+            {
+                if(argv[i].a_type == A_FLOAT)
+                    mess.list[i] = pd::Atom(atom_getfloat(argv+i));
+                else if(argv[i].a_type == A_SYMBOL)
+                    mess.list[i] = pd::Atom(std::string(atom_getsymbol(argv+i)->s_name));
+            }
+            ptr->m_queue.try_enqueue(std::move(mess));
+        }
+        
+        void* m_receiver = nullptr;
+        moodycamel::ConcurrentQueue<Message> m_queue = moodycamel::ConcurrentQueue<Message>(4096);
+    };
+    
+    class BenchInstance : public pd::Instance
+    {
+    public:
+        BenchInstance() : pd::Instance("camomile")
+        {
+            prepareDSP(0, 0, 44100.0, 64);
+            openPatch(CAMOMILE_BENCHMARKS_PATCHES, "messages.pd");
+            setThis();
+            m_legacy = std::make_unique<LegacyReceiver>();
+        }
+        
+        ~BenchInstance()
+        {
+            setThis();
+            m_legacy.reset();
+            closePatch();
+        }
+        
+        size_t tick(std::string const& receiver, const int nmessages, const bool legacy)
+        {
+            beginTick();
+            sendFloat(receiver.c_str(), static_cast<float>(nmessages));
+            endTick();
+            if(legacy)
+            {
+                return m_legacy->process();
+            }
+            m_count = 0;
+            processMessages();
+            return m_count;
+        }
+        
+        void receiveFloat(float) override { ++m_count; }
+        void receiveList(const std::vector<pd::Atom>&) override { ++m_count; }
+        void receiveMessage(const std::string&, const std::vector<pd::Atom>&) override { ++m_count; }
+        
+    private:
+        std::unique_ptr<LegacyReceiver> m_legacy;
+        size_t m_count = 0;
+    };
+}
+
+int main(int argc, char** argv)
+{
+    const double seconds = argc > 1 ? std::max(std::atof(argv[1]), 0.1) : 1.0;
+    const int nmessages = argc > 2 ? std::max(std::atoi(argv[2]), 1) : 64;
+    
+    BenchInstance instance;
+    std::printf("seconds per run: %.1f, messages per tick: %d\n", seconds, nmessages);
+    std::printf("%-10s %-8s %16s %14s %10s\n", "shape", "path", "messages/s", "allocs/msg", "speedup");
+    for(auto const* shape : {"float", "list", "message"})
+    {
+        double rates[2] = {0.0, 0.0};
+        for(int legacy = 1; legacy >= 0; --legacy)
+        {
+            std::string const receiver = std::string(legacy ? "bench-legacy-" : "bench-camomile-") + shape;
+            // The first ticks warm up the queues, the pools and the reused lists.
+            for(int i = 0; i < 16; ++i)
+            {
+                instance.tick(receiver, nmessages, legacy);
+            }
+            size_t count = 0;
+            size_t const allocated = allocations.load();
+            auto const begin = std::chrono::steady_clock::now();
+            auto end = begin;
+            while(std::chrono::duration<double>(end - begin).count() < seconds)
+            {
+                count += instance.tick(receiver, nmessages, legacy);
+                end = std::chrono::steady_clock::now();
+            }
+            const double elapsed = std::chrono::duration<double>(end - begin).count();
+            const double allocs = count ? static_cast<double>(allocations.load() - allocated) / static_cast<double>(count) : 0.0;
+            rates[legacy] = static_cast<double>(count) / elapsed;
+            std::printf("%-10s %-8s %16.0f %14.2f %9.2fx\n", shape, legacy ? "before" : "after", rates[legacy], allocs,
+                        rates[1] > 0.0 ? rates[legacy] / rates[1] : 0.0);
+        }
+    }
+    std::printf("messages dropped by the instance: %zu\n", instance.getMessageOverflows());
+    return 0;
+}
@@ -62,6 +62,29 @@ namespace pd
         libpd_read_array(output.data(), m_name.c_str(), 0, size);
     }
     
+    void Array::read(std::vector<float>& output, const size_t from, const size_t to) const
+    {
+        if(from < to && to <= output.size())
+        {
+            libpd_set_instance(static_cast<t_pdinstance *>(m_instance));
+            libpd_read_array(output.data()+from, m_name.c_str(), static_cast<int>(from), static_cast<int>(to - from));
+        }
+    }
+    
+    bool Array::getChanges(unsigned int& version, size_t& size, size_t& from, size_t& to) const noexcept
+    {
+        int s = 0, f = 0, t = 0;
+        libpd_set_instance(static_cast<t_pdinstance *>(m_instance));
+        if(libpd_array_get_changes(m_name.c_str(), &version, &s, &f, &t) < 0)
+        {
+            return false;
+        }
+        size = static_cast<size_t>(s);
+        from = static_cast<size_t>(f);
+        to   = static_cast<size_t>(t);
+        return true;
+    }
+    
     void Array::write(std::vector<float> const& input)
     {
         libpd_set_instance(static_cast<t_pdinstance *>(m_instance));
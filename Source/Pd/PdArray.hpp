@@ -53,6 +53,15 @@ namespace pd
         //! @brief Gets the values of the array.
         void read(std::vector<float>& output) const;
         
+        //! @brief Gets the values of a range of the array.
+        //! @details The output must have the size of the array.
+        void read(std::vector<float>& output, const size_t from, const size_t to) const;
+        
+        //! @brief Gets the size of the array and the range modified since a version.
+        //! @details Each client keeps the last version it has seen, that is replaced by the
+        //! current version of the array. Returns false if the array doesn't exist.
+        bool getChanges(unsigned int& version, size_t& size, size_t& from, size_t& to) const noexcept;
+        
         //! @brief Writes the values of the array.
         void write(std::vector<float> const& input);
         
@@ -42,6 +42,13 @@ namespace pd
         //! @brief Get the string.
         inline std::string const& getSymbol() const noexcept { return symbol; }
         
+        //! @brief Set the float value.
+        inline void setFloat(const float val) noexcept { type = FLOAT; value = val; }
+        
+        //! @brief Set the string.
+        //! @details The memory of the string is reused when possible.
+        inline void setSymbol(const char* sym) { type = SYMBOL; value = 0; symbol.assign(sym); }
+        
         //! @brief Compare two atoms.
         inline bool operator==(Atom const& other) const noexcept
         {
@@ -6,6 +6,10 @@
 
 #include <limits>
 #include <cmath>
+#include <cstring>
+#include <cstdio>
+#include <algorithm>
+#include <unordered_map>
 
 #include "PdGui.hpp"
 #include "PdInstance.hpp"
@@ -65,51 +69,62 @@ namespace pd
         return (binbuf_getvec(x->a_text.te_binbuf));
     }
 
+    // The classes are shared by all the instances, so the type of a class is
+    // computed from its name once and then retrieved from its address.
+    static Gui::Type getClassType(t_class const* c)
+    {
+        static thread_local std::unordered_map<t_class const*, Gui::Type> types;
+        auto const it = types.find(c);
+        if(it != types.end())
+        {
+            return it->second;
+        }
+        static const std::pair<char const*, Gui::Type> names[] =
+        {
+            {"bng", Gui::Type::Bang},
+            {"hsl", Gui::Type::HorizontalSlider},
+            {"vsl", Gui::Type::VerticalSlider},
+            {"tgl", Gui::Type::Toggle},
+            {"nbx", Gui::Type::Number},
+            {"vradio", Gui::Type::VerticalRadio},
+            {"hradio", Gui::Type::HorizontalRadio},
+            {"cnv", Gui::Type::Panel},
+            {"vu", Gui::Type::VuMeter},
+            {"text", Gui::Type::Comment},
+            {"gatom", Gui::Type::AtomNumber},
+            {"array", Gui::Type::Array},
+            {"canvas", Gui::Type::GraphOnParent}
+        };
+        Gui::Type type = Gui::Type::Undefined;
+        if(c && c->c_name)
+        {
+            for(auto const& name : names)
+            {
+                if(!strcmp(c->c_name->s_name, name.first))
+                {
+                    type = name.second;
+                    break;
+                }
+            }
+        }
+        types.emplace(c, type);
+        return type;
+    }
+
     Gui::Gui(void* ptr, void* patch, Instance* instance) noexcept :
     Object(ptr, patch, instance), m_type(Type::Undefined)
     {
-        const std::string name = getName();
-        if(name == "bng")
-        {
-           m_type = Type::Bang;
-        }
-        else if(name == "hsl")
-        {
-           m_type = Type::HorizontalSlider;
-        }
-        else if(name == "vsl")
-        {
-           m_type = Type::VerticalSlider;
-        }
-        else if(name == "tgl")
-        {
-           m_type = Type::Toggle;
-        }
-        else if(name == "nbx")
-        {
-           m_type = Type::Number;
-        }
-        else if(name == "vradio")
-        {
-           m_type = Type::VerticalRadio;
-        }
-        else if(name == "hradio")
-        {
-           m_type = Type::HorizontalRadio;
-        }
-        else if(name == "cnv")
-        {
-           m_type = Type::Panel;
-        }
-        else if(name == "vu")
+        if(!m_ptr)
         {
-           m_type = Type::VuMeter;
+            return;
         }
-        else if(name == "text")
+        m_type = getClassType(pd_class(static_cast<t_pd*>(m_ptr)));
+        if(m_type == Type::Array)
         {
-           m_type = Type::Comment;
+            // Only the canvas that contains the array is a GUI.
+            m_type = Type::Undefined;
         }
-        else if(name == "gatom")
+        else if(m_type == Type::AtomNumber)
         {
             if(static_cast<t_fake_gatom*>(m_ptr)->a_flavor == A_FLOAT)
                 m_type = Type::AtomNumber;
@@ -117,13 +132,16 @@ namespace pd
                 m_type = Type::AtomSymbol;
             else if(static_cast<t_fake_gatom*>(m_ptr)->a_flavor == A_NULL)
                 m_type = Type::AtomList;
+            else
+                m_type = Type::Undefined;
         }
-        else if(name == "canvas")
+        else if(m_type == Type::GraphOnParent)
         {
+            m_type = Type::Undefined;
             if(static_cast<t_canvas*>(m_ptr)->gl_list)
             {
                 t_class* c = static_cast<t_canvas*>(m_ptr)->gl_list->g_pd;
-                if(c && c->c_name && std::string(c->c_name->s_name) == std::string("array"))
+                if(getClassType(c) == Type::Array)
                 {
                     m_type = Type::Array;
                 }
@@ -131,7 +149,6 @@ namespace pd
             if(m_type != Type::Array && static_cast<t_canvas*>(m_ptr)->gl_isgraph)
             {
                 m_type = Type::GraphOnParent;
-                canvas_vis(static_cast<t_canvas*>(m_ptr), 1.f);
             }
         }
     }
@@ -278,6 +295,70 @@ namespace pd
         return 0.f;
     }
     
+    size_t Gui::getHash() const noexcept
+    {
+        if(!m_ptr || (m_type != Type::AtomSymbol && m_type != Type::AtomList))
+            return 0;
+        t_binbuf* binbuf = static_cast<t_fake_gatom*>(m_ptr)->a_text.te_binbuf;
+        if(m_type == Type::AtomSymbol)
+        {
+            return reinterpret_cast<size_t>(atom_getsymbol(fake_gatom_getatom(static_cast<t_fake_gatom*>(m_ptr))));
+        }
+        int const ac = binbuf_getnatom(binbuf);
+        t_atom const* av = binbuf_getvec(binbuf);
+        size_t hash = static_cast<size_t>(ac);
+        for(int i = 0; i < ac; ++i)
+        {
+            size_t key = 0;
+            if(av[i].a_type == A_FLOAT)
+            {
+                t_float const f = av[i].a_w.w_float;
+                std::memcpy(&key, &f, std::min(sizeof(key), sizeof(f)));
+            }
+            else if(av[i].a_type == A_SYMBOL)
+            {
+                key = reinterpret_cast<size_t>(av[i].a_w.w_symbol);
+            }
+            hash = (hash ^ key) * static_cast<size_t>(1099511628211ull);
+        }
+        return hash;
+    }
+    
+    void Gui::getText(char* text, size_t size) const noexcept
+    {
+        if(!size)
+            return;
+        text[0] = '\0';
+        if(!m_ptr || (m_type != Type::AtomSymbol && m_type != Type::AtomList))
+            return;
+        if(m_type == Type::AtomSymbol)
+        {
+            std::snprintf(text, size, "%s", atom_getsymbol(fake_gatom_getatom(static_cast<t_fake_gatom*>(m_ptr)))->s_name);
+            return;
+        }
+        t_binbuf* binbuf = static_cast<t_fake_gatom*>(m_ptr)->a_text.te_binbuf;
+        int const ac = binbuf_getnatom(binbuf);
+        t_atom const* av = binbuf_getvec(binbuf);
+        size_t length = 0;
+        for(int i = 0; i < ac && length + 1 < size; ++i)
+        {
+            char const* separator = length ? " " : "";
+            int written = 0;
+            if(av[i].a_type == A_FLOAT)
+            {
+                written = std::snprintf(text + length, size - length, "%s%g", separator, av[i].a_w.w_float);
+            }
+            else if(av[i].a_type == A_SYMBOL)
+            {
+                written = std::snprintf(text + length, size - length, "%s%s", separator, av[i].a_w.w_symbol->s_name);
+            }
+            if(written > 0)
+            {
+                length = std::min(length + static_cast<size_t>(written), size - 1);
+            }
+        }
+    }
+    
     void Gui::setValue(float value) noexcept
     {
         if(!m_ptr || m_type == Type::Comment || m_type == Type::AtomSymbol)
@@ -87,6 +87,13 @@ namespace pd
         
         float getValue() const noexcept;
         
+        //! @brief Gets a key that changes with the symbol or the list of an atom GUI.
+        size_t getHash() const noexcept;
+        
+        //! @brief Writes the symbol or the list of an atom GUI in a text of the size.
+        //! @details The instance must be locked, the method doesn't allocate.
+        void getText(char* text, size_t size) const noexcept;
+        
         void setValue(float value) noexcept;
         
         size_t getNumberOfSteps() const noexcept;
@@ -95,10 +102,12 @@ namespace pd
         
         unsigned int getForegroundColor() const noexcept;
         
+        //! @brief Gets the symbol of an atom GUI, the instance must be locked.
         std::string getSymbol() const noexcept;
         
         void setSymbol(std::string const& value) noexcept;
         
+        //! @brief Gets the list of an atom GUI, the instance must be locked.
         std::vector<Atom> getList() const noexcept;
         
         void setList(std::vector<Atom> const& value) noexcept;
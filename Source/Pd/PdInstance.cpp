@@ -6,6 +6,8 @@
 
 #include <algorithm>
 #include <iostream>
+#include <cstring>
+#include <cassert>
 #include "PdInstance.hpp"
 #include "PdPatch.hpp"
 
@@ -14,100 +16,401 @@ extern "C"
 #include <z_libpd.h>
 #include "x_libpd_multi.h"
 #include "x_libpd_extra_utils.h"
+#include <s_stuff.h>
 }
 
 extern "C"
 {
     struct pd::Instance::internal
     {
-        static void instance_multi_bang(pd::Instance* ptr, const char *recv)
+        //! @brief Gets if the hook is called by the previous instance that is faded out or released.
+        static bool is_retired(pd::Instance* ptr)
         {
-            ptr->m_message_queue.try_enqueue({std::string("bang")});
+            void* retired = ptr->m_retired.load();
+            return retired && libpd_this_instance() == retired;
         }
         
-        static void instance_multi_float(pd::Instance* ptr, const char *recv, float f)
+        //! @brief Gets the instance whose tick is performed by the current thread.
+        static pd::Instance const*& ticking()
         {
-            ptr->m_message_queue.try_enqueue({std::string("float"), std::vector<Atom>(1, f)});
+            static thread_local pd::Instance const* instance = nullptr;
+            return instance;
         }
         
-        static void instance_multi_symbol(pd::Instance* ptr, const char *recv, const char *sym)
+        //! @brief Locks the instance unless the current thread is within one of its ticks.
+        struct lock_guard
         {
-            ptr->m_message_queue.try_enqueue({std::string("symbol"), std::vector<Atom>(1, std::string(sym))});
+            lock_guard(pd::Instance const* ptr) : locked(ticking() != ptr)
+            {
+                if(locked)
+                {
+                    sys_lock();
+                    ++(ptr->m_lock_count);
+                }
+            }
+            
+            ~lock_guard()
+            {
+                if(locked)
+                {
+                    sys_unlock();
+                }
+            }
+            
+            bool const locked;
+        };
+        
+        static t_pd* find(const char* receiver)
+        {
+            return gensym(receiver)->s_thing;
+        }
+        
+        static void set_atoms(t_atom* argv, const std::vector<Atom>& list)
+        {
+            for(size_t i = 0; i < list.size(); ++i)
+            {
+                if(list[i].isFloat())
+                    SETFLOAT(argv+i, list[i].getFloat());
+                else if(list[i].isSymbol())
+                    SETSYMBOL(argv+i, gensym(list[i].getSymbol().c_str()));
+                else
+                    SETFLOAT(argv+i, 0.0);
+            }
+        }
+        
+        static void instance_multi_enqueue(pcontext* context, decltype(Message::type) type, const char* selector, int argc, t_atom *argv)
+        {
+            pd::Instance* ptr = context->owner;
+            if(is_retired(ptr))
+            {
+                return;
+            }
+            Message mess;
+            mess.type       = type;
+            mess.selector   = selector;
+            mess.size       = static_cast<size_t>(std::max(argc, 0));
+            mess.block      = 0;
+            mess.context    = context;
+            iatom* atoms    = mess.atoms;
+            if(mess.size > message_capacity)
+            {
+                // The blocks are offsets in the pool, the small ones first.
+                size_t block;
+                if((mess.size <= block_capacity && ptr->m_message_blocks.try_dequeue(block)) ||
+                   (mess.size <= large_capacity && ptr->m_message_larges.try_dequeue(block)))
+                {
+                    mess.block = block + 1;
+                    atoms = ptr->m_message_pool.data() + block;
+                }
+                else
+                {
+                    ++(ptr->m_message_overflows);
+                    return;
+                }
+            }
+            for(size_t i = 0; i < mess.size; ++i)
+            {
+                if(argv[i].a_type == A_SYMBOL)
+                    atoms[i] = {atom_getsymbol(argv+i)->s_name, 0.f};
+                else
+                    atoms[i] = {nullptr, argv[i].a_type == A_FLOAT ? atom_getfloat(argv+i) : 0.f};
+            }
+            ++(context->messages);
+            if(!ptr->m_message_queue.try_enqueue(mess))
+            {
+                ++(ptr->m_message_overflows);
+                release(ptr, mess);
+            }
         }
         
-        static void instance_multi_list(pd::Instance* ptr, const char *recv, int argc, t_atom *argv)
+        static void release(pd::Instance* ptr, Message& mess)
         {
-            Message mess{std::string("list"), std::vector<Atom>(argc)};
-            for(int i = 0; i < argc; ++i)
+            if(mess.block)
             {
-                if(argv[i].a_type == A_FLOAT)
-                    mess.list[i] = Atom(atom_getfloat(argv+i));
-                else if(argv[i].a_type == A_SYMBOL)
-                    mess.list[i] = Atom(std::string(atom_getsymbol(argv+i)->s_name));
+                const size_t block = mess.block - 1;
+                if(block < block_number * block_capacity)
+                    ptr->m_message_blocks.try_enqueue(block);
+                else
+                    ptr->m_message_larges.try_enqueue(block);
             }
-            ptr->m_message_queue.try_enqueue(std::move(mess));
+            --(mess.context->messages);
+            mess.block  = 0;
         }
         
-        static void instance_multi_message(pd::Instance* ptr, const char *recv, const char *msg, int argc, t_atom *argv)
+        static void instance_multi_bang(pcontext* context, const char *recv)
         {
-            Message mess{msg, std::vector<Atom>(argc)};
-            for(int i = 0; i < argc; ++i)
+            instance_multi_enqueue(context, Message::BANG, nullptr, 0, nullptr);
+        }
+        
+        static void instance_multi_float(pcontext* context, const char *recv, float f)
+        {
+            t_atom av;
+            SETFLOAT(&av, f);
+            instance_multi_enqueue(context, Message::FLOAT, nullptr, 1, &av);
+        }
+        
+        static void instance_multi_symbol(pcontext* context, const char *recv, const char *sym)
+        {
+            pd::Instance* ptr = context->owner;
+            if(is_retired(ptr))
+            {
+                return;
+            }
+            // the name of a symbol of the instance is interned
+            Message mess;
+            mess.type       = Message::SYMBOL;
+            mess.selector   = nullptr;
+            mess.size       = 1;
+            mess.block      = 0;
+            mess.context    = context;
+            mess.atoms[0]   = {sym, 0.f};
+            ++(context->messages);
+            if(!ptr->m_message_queue.try_enqueue(mess))
             {
-                if(argv[i].a_type == A_FLOAT)
-                    mess.list[i] = Atom(atom_getfloat(argv+i));
-                else if(argv[i].a_type == A_SYMBOL)
-                    mess.list[i] = Atom(std::string(atom_getsymbol(argv+i)->s_name));
+                ++(ptr->m_message_overflows);
+                release(ptr, mess);
             }
-            ptr->m_message_queue.try_enqueue(std::move(mess));
+        }
+        
+        static void instance_multi_list(pcontext* context, const char *recv, int argc, t_atom *argv)
+        {
+            instance_multi_enqueue(context, Message::LIST, nullptr, argc, argv);
+        }
+        
+        static void instance_multi_message(pcontext* context, const char *recv, const char *msg, int argc, t_atom *argv)
+        {
+            instance_multi_enqueue(context, Message::MESSAGE, msg, argc, argv);
         }
 
         //////////////////////////////////////////////////////////////////////////////////////////
         //////////////////////////////////////////////////////////////////////////////////////////
         
+        //! @brief Gets the position of the event within the current block from the logical time.
+        static int get_midi_offset(pd::Instance* ptr)
+        {
+            const double offset = clock_gettimesincewithunits(ptr->m_dsp_time, 1, 1);
+            return std::min(std::max(static_cast<int>(offset), 0), ptr->m_blocksize - 1);
+        }
+        
         static void instance_multi_noteon(pd::Instance* ptr, int channel, int pitch, int velocity)
         {
-            ptr->m_midi_queue.try_enqueue({midievent::NOTEON, channel, pitch, velocity});
+            if(is_retired(ptr))
+            {
+                return;
+            }
+            ptr->m_midi_queue.try_enqueue({midievent::NOTEON, channel, pitch, velocity, get_midi_offset(ptr)});
         }
         
         static void instance_multi_controlchange(pd::Instance* ptr, int channel, int controller, int value)
         {
-            ptr->m_midi_queue.try_enqueue({midievent::CONTROLCHANGE, channel, controller, value});
+            if(is_retired(ptr))
+            {
+                return;
+            }
+            ptr->m_midi_queue.try_enqueue({midievent::CONTROLCHANGE, channel, controller, value, get_midi_offset(ptr)});
         }
         
         static void instance_multi_programchange(pd::Instance* ptr, int channel, int value)
         {
-            ptr->m_midi_queue.try_enqueue({midievent::PROGRAMCHANGE, channel, value, 0});
+            if(is_retired(ptr))
+            {
+                return;
+            }
+            ptr->m_midi_queue.try_enqueue({midievent::PROGRAMCHANGE, channel, value, 0, get_midi_offset(ptr)});
         }
         
         static void instance_multi_pitchbend(pd::Instance* ptr, int channel, int value)
         {
-            ptr->m_midi_queue.try_enqueue({midievent::PITCHBEND, channel, value, 0});
+            if(is_retired(ptr))
+            {
+                return;
+            }
+            ptr->m_midi_queue.try_enqueue({midievent::PITCHBEND, channel, value, 0, get_midi_offset(ptr)});
         }
         
         static void instance_multi_aftertouch(pd::Instance* ptr, int channel, int value)
         {
-            ptr->m_midi_queue.try_enqueue({midievent::AFTERTOUCH, channel, value, 0});
+            if(is_retired(ptr))
+            {
+                return;
+            }
+            ptr->m_midi_queue.try_enqueue({midievent::AFTERTOUCH, channel, value, 0, get_midi_offset(ptr)});
         }
         
         static void instance_multi_polyaftertouch(pd::Instance* ptr, int channel, int pitch, int value)
         {
-            ptr->m_midi_queue.try_enqueue({midievent::POLYAFTERTOUCH, channel, pitch, value});
+            if(is_retired(ptr))
+            {
+                return;
+            }
+            ptr->m_midi_queue.try_enqueue({midievent::POLYAFTERTOUCH, channel, pitch, value, get_midi_offset(ptr)});
         }
         
         static void instance_multi_midibyte(pd::Instance* ptr, int port, int byte)
         {
-            ptr->m_midi_queue.try_enqueue({midievent::MIDIBYTE, port, byte, 0});
+            if(is_retired(ptr))
+            {
+                return;
+            }
+            ptr->m_midi_queue.try_enqueue({midievent::MIDIBYTE, port, byte, 0, get_midi_offset(ptr)});
         }
         
         //////////////////////////////////////////////////////////////////////////////////////////
         //////////////////////////////////////////////////////////////////////////////////////////
         
-        static void instance_multi_print(pd::Instance* ptr, char const* s)
+        static void instance_multi_print(pcontext* printer, char const* s)
         {
-            fputs (s, stderr);
-            fputs ("\n", stderr);
-            fflush (stderr);
-            ptr->m_print_queue.try_enqueue(std::string(s));
+            if(is_retired(printer->owner))
+            {
+                return;
+            }
+            // Pd prints a line in several parts, so the line is assembled
+            // here, under the lock of the Pd instance that prints it (the
+            // current and the pending ones have their own buffers), and
+            // queued when it ends.
+            for(; *s; ++s)
+            {
+                if(*s == '\n')
+                {
+                    instance_multi_print_line(printer);
+                }
+                else
+                {
+                    if(printer->size == print_length)
+                    {
+                        instance_multi_print_line(printer);
+                    }
+                    printer->text[printer->size++] = *s;
+                }
+            }
+        }
+        
+        static void instance_multi_print_line(pcontext* printer)
+        {
+            // The line is copied in fixed-size fragments that are all queued
+            // at once or not at all, so the reader never gets a partial line.
+            pd::Instance* ptr = printer->owner;
+            char const* text = printer->text.data();
+            size_t size = printer->size;
+            const size_t count = std::max(size_t(1), (size + print_capacity - 2) / (print_capacity - 1));
+            const size_t line  = ptr->m_print_lines++;
+            for(size_t i = 0; i < count; ++i)
+            {
+                Print& print = printer->fragments[i];
+                const size_t length = std::min(size, print_capacity - 1);
+                std::copy_n(text, length, print.text);
+                print.text[length] = '\0';
+                print.line  = line;
+                print.count = count;
+                text += length;
+                size -= length;
+            }
+            if(!ptr->m_print_queue.try_enqueue_bulk(printer->fragments.data(), count))
+            {
+                ++(ptr->m_print_overflows);
+            }
+            printer->size = 0;
+        }
+        
+        static void instance_multi_file(pd::Instance* ptr, char const* dir, char const* name)
+        {
+            if(is_retired(ptr))
+            {
+                return;
+            }
+            // The path is copied in a preallocated slot and only reported the first time the
+            // file is opened, the hashes of the reported files are inserted without locking.
+            File file;
+            const size_t dsize = strlen(dir), nsize = strlen(name);
+            if(dsize + nsize + 2 > file_capacity)
+            {
+                return;
+            }
+            std::copy_n(dir, dsize, file.path);
+            file.path[dsize] = '/';
+            std::copy_n(name, nsize + 1, file.path + dsize + 1);
+            
+            uint64_t hash = 14695981039346656037ull;
+            for(char const* c = file.path; *c; ++c)
+            {
+                hash = (hash ^ static_cast<unsigned char>(*c)) * 1099511628211ull;
+            }
+            hash = std::max(hash, file_removed + 1);
+            auto& hashes = ptr->m_file_hashes;
+            for(size_t i = 0; i < file_hashes; ++i)
+            {
+                auto& slot = hashes[(hash + i) % file_hashes];
+                uint64_t current = slot.load();
+                if(current == 0 && slot.compare_exchange_strong(current, hash))
+                {
+                    if(!ptr->m_file_queue.try_enqueue(file))
+                    {
+                        // The file is reported again the next time it is opened.
+                        slot.store(file_removed);
+                    }
+                    return;
+                }
+                if(current == hash)
+                {
+                    return;
+                }
+            }
+            ptr->m_file_queue.try_enqueue(file);
+        }
+        
+        //////////////////////////////////////////////////////////////////////////////////////////
+        //////////////////////////////////////////////////////////////////////////////////////////
+        
+        static void instance_create(pd::Instance* ptr, pinstance& p)
+        {
+            p.instance = libpd_new_instance();
+            libpd_set_instance(static_cast<t_pdinstance *>(p.instance));
+            p.midi_receiver = libpd_multi_midi_new(ptr,
+                                                   reinterpret_cast<t_libpd_multi_noteonhook>(instance_multi_noteon),
+                                                   reinterpret_cast<t_libpd_multi_controlchangehook>(instance_multi_controlchange),
+                                                   reinterpret_cast<t_libpd_multi_programchangehook>(instance_multi_programchange),
+                                                   reinterpret_cast<t_libpd_multi_pitchbendhook>(instance_multi_pitchbend),
+                                                   reinterpret_cast<t_libpd_multi_aftertouchhook>(instance_multi_aftertouch),
+                                                   reinterpret_cast<t_libpd_multi_polyaftertouchhook>(instance_multi_polyaftertouch),
+                                                   reinterpret_cast<t_libpd_multi_midibytehook>(instance_multi_midibyte));
+            p.context = new pcontext{ptr};
+            p.print_receiver = libpd_multi_print_new(p.context,
+                                                     reinterpret_cast<t_libpd_multi_printhook>(instance_multi_print));
+            p.file_receiver = libpd_multi_file_new(ptr,
+                                                   reinterpret_cast<t_libpd_multi_filehook>(instance_multi_file));
+            
+            p.message_receiver = libpd_multi_receiver_new(p.context, ptr->m_symbol.c_str(),
+                                                          reinterpret_cast<t_libpd_multi_banghook>(instance_multi_bang),
+                                                          reinterpret_cast<t_libpd_multi_floathook>(instance_multi_float),
+                                                          reinterpret_cast<t_libpd_multi_symbolhook>(instance_multi_symbol),
+                                                          reinterpret_cast<t_libpd_multi_listhook>(instance_multi_list),
+                                                          reinterpret_cast<t_libpd_multi_messagehook>(instance_multi_message));
+        }
+        
+        static void instance_free(pinstance& p)
+        {
+            if(p.instance)
+            {
+                libpd_set_instance(static_cast<t_pdinstance *>(p.instance));
+                // The messages sent while the patch is closed are not queued.
+                pd_free((t_pd *)p.message_receiver);
+                if(p.patch)
+                {
+                    libpd_closefile(p.patch);
+                }
+                pd_free((t_pd *)p.midi_receiver);
+                pd_free((t_pd *)p.print_receiver);
+                pd_free((t_pd *)p.file_receiver);
+                if(p.params_table)
+                {
+                    pd_free((t_pd *)p.params_table);
+                }
+                libpd_free_instance(static_cast<t_pdinstance *>(p.instance));
+                // The queued messages refer to the names of the symbols of the instance.
+                assert(p.context->messages.load() == 0 && "messages of a freed instance");
+                delete p.context;
+                p = pinstance();
+            }
         }
     };
     
@@ -118,37 +421,50 @@ namespace pd
     //////////////////////////////////////////////////////////////////////////////////////////
     //////////////////////////////////////////////////////////////////////////////////////////
     
-    Instance::Instance(std::string const& symbol)
+    Instance::Instance(std::string const& symbol) : m_symbol(symbol)
     {
         libpd_multi_init();
-        m_instance = libpd_new_instance();
-        libpd_set_instance(static_cast<t_pdinstance *>(m_instance));
-        m_midi_receiver = libpd_multi_midi_new(this,
-                                               reinterpret_cast<t_libpd_multi_noteonhook>(internal::instance_multi_noteon),
-                                               reinterpret_cast<t_libpd_multi_controlchangehook>(internal::instance_multi_controlchange),
-                                               reinterpret_cast<t_libpd_multi_programchangehook>(internal::instance_multi_programchange),
-                                               reinterpret_cast<t_libpd_multi_pitchbendhook>(internal::instance_multi_pitchbend),
-                                               reinterpret_cast<t_libpd_multi_aftertouchhook>(internal::instance_multi_aftertouch),
-                                               reinterpret_cast<t_libpd_multi_polyaftertouchhook>(internal::instance_multi_polyaftertouch),
-                                               reinterpret_cast<t_libpd_multi_midibytehook>(internal::instance_multi_midibyte));
-        m_print_receiver = libpd_multi_print_new(this,
-                                                  reinterpret_cast<t_libpd_multi_printhook>(internal::instance_multi_print));
-        
-        m_message_receiver = libpd_multi_receiver_new(this, symbol.c_str(),
-                                                      reinterpret_cast<t_libpd_multi_banghook>(internal::instance_multi_bang),
-                                                      reinterpret_cast<t_libpd_multi_floathook>(internal::instance_multi_float),
-                                                      reinterpret_cast<t_libpd_multi_symbolhook>(internal::instance_multi_symbol),
-                                                      reinterpret_cast<t_libpd_multi_listhook>(internal::instance_multi_list),
-                                                      reinterpret_cast<t_libpd_multi_messagehook>(internal::instance_multi_message));
-        m_atoms = malloc(sizeof(t_atom) * 512);
+        pinstance current;
+        internal::instance_create(this, current);
+        m_instance          = current.instance;
+        m_midi_receiver     = current.midi_receiver;
+        m_print_receiver    = current.print_receiver;
+        m_context           = current.context;
+        m_file_receiver     = current.file_receiver;
+        m_message_receiver  = current.message_receiver;
+        m_atoms = malloc(sizeof(t_atom) * atoms_capacity);
+        m_message_pool.resize(block_number * block_capacity + large_number * large_capacity);
+        for(size_t i = 0; i < block_number; ++i)
+        {
+            m_message_blocks.try_enqueue(i * block_capacity);
+        }
+        for(size_t i = 0; i < large_number; ++i)
+        {
+            m_message_larges.try_enqueue(block_number * block_capacity + i * large_capacity);
+        }
+        m_message_list.reserve(large_capacity);
     }
     
     Instance::~Instance()
     {
+        Message mess;
+        while(m_message_queue.try_dequeue(mess))
+        {
+            internal::release(this, mess);
+        }
+        internal::instance_free(m_pending);
+        internal::instance_free(m_previous);
+        m_retired.store(nullptr);
         closePatch();
         pd_free((t_pd *)m_midi_receiver);
         pd_free((t_pd *)m_print_receiver);
+        delete m_context;
+        pd_free((t_pd *)m_file_receiver);
         pd_free((t_pd *)m_message_receiver);
+        if(m_params_table)
+        {
+            pd_free((t_pd *)m_params_table);
+        }
         libpd_set_instance(static_cast<t_pdinstance *>(m_instance));
         libpd_free_instance(static_cast<t_pdinstance *>(m_instance));
     }
@@ -158,17 +474,24 @@ namespace pd
 
     int Instance::getBlockSize() const noexcept
     {
-        return libpd_blocksize();
+        return m_blocksize;
     }
     
-    void Instance::prepareDSP(const int nins, const int nouts, const double samplerate)
+    void Instance::prepareDSP(const int nins, const int nouts, const double samplerate, const int blocksize)
     {
+        const int pdblksize = libpd_blocksize();
+        m_blocksize = std::max(blocksize / pdblksize, 1) * pdblksize;
         libpd_set_instance(static_cast<t_pdinstance *>(m_instance));
         libpd_init_audio(nins, nouts, (int)samplerate);
+        m_dsp_time = clock_getlogicaltime();
+        m_dsp_inputs = nins;
+        m_dsp_outputs = nouts;
+        m_dsp_samplerate = samplerate;
     }
     
     void Instance::startDSP()
     {
+        m_dsp_running = true;
         t_atom av;
         libpd_set_float(&av, 1.f);
         libpd_message("pd", "dsp", 1, &av);
@@ -176,16 +499,207 @@ namespace pd
     
     void Instance::releaseDSP()
     {
+        m_dsp_running = false;
         t_atom av;
         libpd_set_instance(static_cast<t_pdinstance *>(m_instance));
         libpd_set_float(&av, 0.f);
         libpd_message("pd", "dsp", 1, &av);
     }
     
-    void Instance::performDSP(float const* inputs, float* outputs)
+    void Instance::performDSP(float const** inputs, float** outputs, const int nins, const int nouts, const int nsamples)
+    {
+        const int nticks = nsamples / libpd_blocksize();
+        const int nfaded = std::min(nouts, static_cast<int>(m_fade_channels.size()));
+        if(m_fade_length > 0 && m_fade_buffer.size() < static_cast<size_t>(nfaded * nsamples))
+        {
+            stopFading();
+        }
+        if(m_fade_length > 0)
+        {
+            // The previous instance processes the same inputs until its outputs are faded out.
+            for(int j = 0; j < nfaded; ++j)
+            {
+                m_fade_channels[j] = m_fade_buffer.data() + j * nsamples;
+            }
+            // Two instances are never locked together, so the current one is
+            // unlocked while the previous one performs within a tick.
+            const bool ticking = internal::ticking() == this;
+            if(ticking)
+            {
+                libpd_set_instance(static_cast<t_pdinstance *>(m_instance));
+                sys_unlock();
+            }
+            libpd_set_instance(static_cast<t_pdinstance *>(m_previous.instance));
+            sys_lock();
+            ++m_lock_count;
+            libpd_process_channels(nticks, nins, inputs, nfaded, m_fade_channels.data());
+            sys_unlock();
+            if(ticking)
+            {
+                libpd_set_instance(static_cast<t_pdinstance *>(m_instance));
+                sys_lock();
+                ++m_lock_count;
+            }
+        }
+        libpd_set_instance(static_cast<t_pdinstance *>(m_instance));
+        {
+            internal::lock_guard const lock(this);
+            libpd_process_channels(nticks, nins, inputs, nouts, outputs);
+            // The logical time at the end of the ticks is the start of the next block.
+            m_dsp_time = clock_getlogicaltime();
+        }
+        if(m_fade_length > 0)
+        {
+            const float length = static_cast<float>(m_fade_length);
+            for(int j = 0; j < nfaded; ++j)
+            {
+                float const* previous = m_fade_channels[j];
+                for(int i = 0; i < nsamples; ++i)
+                {
+                    const float gain = std::min(static_cast<float>(m_fade_position + i) / length, 1.f);
+                    outputs[j][i] = outputs[j][i] * gain + previous[i] * (1.f - gain);
+                }
+            }
+            m_fade_position += nsamples;
+            if(m_fade_position >= m_fade_length)
+            {
+                stopFading();
+            }
+        }
+        publishGuis();
+    }
+    
+    void Instance::beginTick()
+    {
+        libpd_set_instance(static_cast<t_pdinstance *>(m_instance));
+        sys_lock();
+        ++m_lock_count;
+        internal::ticking() = this;
+    }
+    
+    void Instance::endTick()
+    {
+        internal::ticking() = nullptr;
+        libpd_set_instance(static_cast<t_pdinstance *>(m_instance));
+        sys_unlock();
+    }
+    
+    //////////////////////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////////////////////
+    
+    size_t Instance::watchGuis(std::vector<Gui> const& guis)
+    {
+        std::vector<gwatch> watched;
+        std::vector<void*> objects;
+        watched.reserve(guis.size());
+        objects.reserve(guis.size());
+        for(auto const& gui : guis)
+        {
+            watched.push_back({gui, 0.f, 0, false, true, nullptr});
+            objects.push_back(const_cast<void*>(gui.getPointer()));
+        }
+        std::sort(objects.begin(), objects.end());
+        objects.erase(std::unique(objects.begin(), objects.end()), objects.end());
+        std::vector<char> found(objects.size());
+        libpd_set_instance(static_cast<t_pdinstance *>(m_instance));
+        internal::lock_guard const lock(this);
+        m_gui_watched.swap(watched);
+        m_gui_objects.swap(objects);
+        m_gui_found.swap(found);
+        m_gui_checked = false;
+        const size_t generation = ++m_gui_generation;
+        m_gui_watching.store(!m_gui_watched.empty());
+        return generation;
+    }
+    
+    bool Instance::dequeueGuiValue(GuiValue& value)
+    {
+        return m_gui_queue.try_dequeue(value);
+    }
+    
+    void Instance::publishGuis()
     {
+        if(!m_gui_watching.load())
+        {
+            return;
+        }
+        // The thread that claims the time publishes the changes.
+        auto const now = std::chrono::steady_clock::now().time_since_epoch().count();
+        auto const interval = std::chrono::duration_cast<std::chrono::steady_clock::duration>(gui_interval).count();
+        auto last = m_gui_time.load();
+        if(now - last < interval || !m_gui_time.compare_exchange_strong(last, now))
+        {
+            return;
+        }
         libpd_set_instance(static_cast<t_pdinstance *>(m_instance));
-        libpd_process_raw(inputs, outputs);
+        internal::lock_guard const lock(this);
+        checkGuis();
+        for(size_t i = 0; i < m_gui_watched.size(); ++i)
+        {
+            auto& watched = m_gui_watched[i];
+            if(!watched.alive)
+            {
+                continue;
+            }
+            auto const type = watched.gui.getType();
+            float value = watched.value;
+            size_t hash = watched.hash;
+            if(type == Gui::Type::AtomSymbol || type == Gui::Type::AtomList)
+            {
+                hash = watched.gui.getHash();
+            }
+            else
+            {
+                value = watched.gui.getValue();
+            }
+            if(!watched.published || value != watched.value || hash != watched.hash)
+            {
+                GuiValue change{i, m_gui_generation, value, {}};
+                if(type == Gui::Type::AtomSymbol || type == Gui::Type::AtomList)
+                {
+                    watched.gui.getText(change.text, sizeof(change.text));
+                }
+                // If the queue is full, the change is published later.
+                if(m_gui_queue.try_enqueue(change))
+                {
+                    watched.value = value;
+                    watched.hash  = hash;
+                    watched.published = true;
+                }
+            }
+        }
+    }
+    
+    void Instance::checkGuis()
+    {
+        // The objects are only looked for in the patch when Pd deleted some of them
+        // since the last check, the watched GUIs that are not found are never read again.
+        const unsigned int deletions = libpd_get_deletions();
+        if(m_gui_checked && deletions == m_gui_deletions)
+        {
+            return;
+        }
+        m_gui_checked   = true;
+        m_gui_deletions = deletions;
+        std::fill(m_gui_found.begin(), m_gui_found.end(), 0);
+        if(m_patch && !m_gui_objects.empty())
+        {
+            libpd_canvas_find_objects(m_patch, static_cast<int>(m_gui_objects.size()), m_gui_objects.data(), m_gui_found.data());
+        }
+        for(auto& watched : m_gui_watched)
+        {
+            void* const ptr = const_cast<void*>(watched.gui.getPointer());
+            auto const it = std::lower_bound(m_gui_objects.begin(), m_gui_objects.end(), ptr);
+            watched.alive = watched.alive && it != m_gui_objects.end() && *it == ptr
+            && m_gui_found[static_cast<size_t>(it - m_gui_objects.begin())];
+            // An object created at the address of a deleted one must be of the same class.
+            if(watched.alive)
+            {
+                void const* cls = *static_cast<t_pd*>(ptr);
+                watched.alive = !watched.cls || watched.cls == cls;
+                watched.cls   = cls;
+            }
+        }
     }
     
     //////////////////////////////////////////////////////////////////////////////////////////
@@ -194,55 +708,119 @@ namespace pd
     void Instance::sendNoteOn(const int channel, const int pitch, const int velocity) const
     {
         libpd_set_instance(static_cast<t_pdinstance *>(m_instance));
-        libpd_noteon(channel-1, pitch, velocity);
+        if(channel > 0 && pitch >= 0 && pitch <= 0x7f && velocity >= 0 && velocity <= 0x7f)
+        {
+            internal::lock_guard const lock(this);
+            inmidi_noteon((channel-1) >> 4, (channel-1) & 0x0f, pitch, velocity);
+        }
     }
     
     void Instance::sendControlChange(const int channel, const int controller, const int value) const
     {
         libpd_set_instance(static_cast<t_pdinstance *>(m_instance));
-        libpd_controlchange(channel-1, controller, value);
+        if(channel > 0 && controller >= 0 && controller <= 0x7f && value >= 0 && value <= 0x7f)
+        {
+            internal::lock_guard const lock(this);
+            inmidi_controlchange((channel-1) >> 4, (channel-1) & 0x0f, controller, value);
+        }
     }
     
     void Instance::sendProgramChange(const int channel, const int value) const
     {
         libpd_set_instance(static_cast<t_pdinstance *>(m_instance));
-        libpd_programchange(channel-1, value);
+        if(channel > 0 && value >= 0 && value <= 0x7f)
+        {
+            internal::lock_guard const lock(this);
+            inmidi_programchange((channel-1) >> 4, (channel-1) & 0x0f, value);
+        }
     }
     
     void Instance::sendPitchBend(const int channel, const int value) const
     {
         libpd_set_instance(static_cast<t_pdinstance *>(m_instance));
-        libpd_pitchbend(channel-1, value);
+        if(channel > 0 && value >= -8192 && value <= 8191)
+        {
+            internal::lock_guard const lock(this);
+            inmidi_pitchbend((channel-1) >> 4, (channel-1) & 0x0f, value + 8192);
+        }
     }
     
     void Instance::sendAfterTouch(const int channel, const int value) const
     {
         libpd_set_instance(static_cast<t_pdinstance *>(m_instance));
-        libpd_aftertouch(channel-1, value);
+        if(channel > 0 && value >= 0 && value <= 0x7f)
+        {
+            internal::lock_guard const lock(this);
+            inmidi_aftertouch((channel-1) >> 4, (channel-1) & 0x0f, value);
+        }
     }
     
     void Instance::sendPolyAfterTouch(const int channel, const int pitch, const int value) const
     {
         libpd_set_instance(static_cast<t_pdinstance *>(m_instance));
-        libpd_polyaftertouch(channel-1, pitch, value);
+        if(channel > 0 && pitch >= 0 && pitch <= 0x7f && value >= 0 && value <= 0x7f)
+        {
+            internal::lock_guard const lock(this);
+            inmidi_polyaftertouch((channel-1) >> 4, (channel-1) & 0x0f, pitch, value);
+        }
     }
     
     void Instance::sendSysEx(const int port, const int byte) const
     {
         libpd_set_instance(static_cast<t_pdinstance *>(m_instance));
-        libpd_sysex(port, byte);
+        if(port >= 0 && port <= 0x0fff && byte >= 0 && byte <= 0xff)
+        {
+            internal::lock_guard const lock(this);
+            inmidi_sysex(port, byte);
+        }
     }
     
     void Instance::sendSysRealTime(const int port, const int byte) const
     {
         libpd_set_instance(static_cast<t_pdinstance *>(m_instance));
-        libpd_sysrealtime(port, byte);
+        if(port >= 0 && port <= 0x0fff && byte >= 0 && byte <= 0xff)
+        {
+            internal::lock_guard const lock(this);
+            inmidi_realtimein(port, byte);
+        }
     }
     
     void Instance::sendMidiByte(const int port, const int byte) const
     {
         libpd_set_instance(static_cast<t_pdinstance *>(m_instance));
-        libpd_midibyte(port, byte);
+        if(port >= 0 && port <= 0x0fff && byte >= 0 && byte <= 0xff)
+        {
+            internal::lock_guard const lock(this);
+            inmidi_byte(port, byte);
+        }
+    }
+    
+    void Instance::sendMidiMessages(unsigned char const* const* messages, int const* sizes, const int nmessages) const
+    {
+        libpd_set_instance(static_cast<t_pdinstance *>(m_instance));
+        internal::lock_guard const lock(this);
+        libpd_process_midi(nmessages, messages, sizes);
+    }
+    
+    //////////////////////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////////////////////
+    
+    void Instance::prepareParameters(const int size)
+    {
+        libpd_set_instance(static_cast<t_pdinstance *>(m_instance));
+        if(m_params_table)
+        {
+            pd_free((t_pd *)m_params_table);
+        }
+        m_params_table = libpd_multi_params_new(size);
+        m_params_size = size;
+    }
+    
+    void Instance::sendParameterRamp(const int index, const float value, const float ramp) const
+    {
+        libpd_set_instance(static_cast<t_pdinstance *>(m_instance));
+        internal::lock_guard const lock(this);
+        libpd_multi_params_set(m_params_table, index, value, ramp);
     }
     
     //////////////////////////////////////////////////////////////////////////////////////////
@@ -251,47 +829,58 @@ namespace pd
     void Instance::sendBang(const char* receiver) const
     {
         libpd_set_instance(static_cast<t_pdinstance *>(m_instance));
-        libpd_bang(receiver);
+        internal::lock_guard const lock(this);
+        if(t_pd* dest = internal::find(receiver))
+        {
+            pd_bang(dest);
+        }
     }
     
     void Instance::sendFloat(const char* receiver, float const value) const
     {
         libpd_set_instance(static_cast<t_pdinstance *>(m_instance));
-        libpd_float(receiver, value);
+        internal::lock_guard const lock(this);
+        if(t_pd* dest = internal::find(receiver))
+        {
+            pd_float(dest, value);
+        }
     }
     
     void Instance::sendSymbol(const char* receiver, const char* symbol) const
     {
         libpd_set_instance(static_cast<t_pdinstance *>(m_instance));
-        libpd_symbol(receiver, symbol);
+        internal::lock_guard const lock(this);
+        if(t_pd* dest = internal::find(receiver))
+        {
+            pd_symbol(dest, gensym(symbol));
+        }
     }
     
     void Instance::sendList(const char* receiver, const std::vector<Atom>& list) const
     {
-        t_atom* argv = static_cast<t_atom*>(m_atoms);
+        // The lists that don't fit in the preallocated atoms, such as the big presets, are allocated.
+        std::vector<t_atom> heap(list.size() > atoms_capacity ? list.size() : 0);
+        t_atom* argv = heap.empty() ? static_cast<t_atom*>(m_atoms) : heap.data();
         libpd_set_instance(static_cast<t_pdinstance *>(m_instance));
-        for(size_t i = 0; i < list.size(); ++i)
+        internal::lock_guard const lock(this);
+        internal::set_atoms(argv, list);
+        if(t_pd* dest = internal::find(receiver))
         {
-            if(list[i].isFloat())
-                libpd_set_float(argv+i, list[i].getFloat());
-            else
-                libpd_set_symbol(argv+i, list[i].getSymbol().c_str());
+            pd_list(dest, &s_list, static_cast<int>(list.size()), argv);
         }
-        libpd_list(receiver, (int)list.size(), argv);
     }
     
     void Instance::sendMessage(const char* receiver, const char* msg, const std::vector<Atom>& list) const
     {
-        t_atom* argv = static_cast<t_atom*>(m_atoms);
+        std::vector<t_atom> heap(list.size() > atoms_capacity ? list.size() : 0);
+        t_atom* argv = heap.empty() ? static_cast<t_atom*>(m_atoms) : heap.data();
         libpd_set_instance(static_cast<t_pdinstance *>(m_instance));
-        for(size_t i = 0; i < list.size(); ++i)
+        internal::lock_guard const lock(this);
+        internal::set_atoms(argv, list);
+        if(t_pd* dest = internal::find(receiver))
         {
-            if(list[i].isFloat())
-                libpd_set_float(argv+i, list[i].getFloat());
-            else
-                libpd_set_symbol(argv+i, list[i].getSymbol().c_str());
+            pd_typedmess(dest, gensym(msg), static_cast<int>(list.size()), argv);
         }
-        libpd_message(receiver, msg, (int)list.size(), argv);
     }
     
     void Instance::processMessages()
@@ -299,16 +888,30 @@ namespace pd
         Message mess;
         while(m_message_queue.try_dequeue(mess))
         {
-            if(mess.selector == "bang")
+            iatom const* atoms = mess.block ? m_message_pool.data() + (mess.block - 1) : mess.atoms;
+            m_message_list.resize(mess.size);
+            for(size_t i = 0; i < mess.size; ++i)
+            {
+                if(atoms[i].symbol)
+                    m_message_list[i].setSymbol(atoms[i].symbol);
+                else
+                    m_message_list[i].setFloat(atoms[i].value);
+            }
+            internal::release(this, mess);
+            
+            if(mess.type == Message::BANG)
                 receiveBang();
-            else if(mess.selector == "float")
-                receiveFloat(mess.list[0].getFloat());
-            else if(mess.selector == "symbol")
-                receiveSymbol(mess.list[0].getSymbol());
-            else if(mess.selector == "list")
-                receiveList(mess.list);
-            else
-                receiveMessage(mess.selector, mess.list);
+            else if(mess.type == Message::FLOAT && !m_message_list.empty())
+                receiveFloat(m_message_list[0].getFloat());
+            else if(mess.type == Message::SYMBOL && !m_message_list.empty())
+                receiveSymbol(m_message_list[0].getSymbol());
+            else if(mess.type == Message::LIST)
+                receiveList(m_message_list);
+            else if(mess.type == Message::MESSAGE)
+            {
+                m_message_selector.assign(mess.selector);
+                receiveMessage(m_message_selector, m_message_list);
+            }
         }
     }
     
@@ -317,6 +920,7 @@ namespace pd
         midievent event;
         while(m_midi_queue.try_dequeue(event))
         {
+            m_midi_offset = event.offset;
             if(event.type == midievent::NOTEON)
                 receiveNoteOn(event.midi1+1, event.midi2, event.midi3);
             else if(event.type == midievent::CONTROLCHANGE)
@@ -332,34 +936,75 @@ namespace pd
             else if(event.type == midievent::MIDIBYTE)
                 receiveMidiByte(event.midi1, event.midi2);
         }
+        m_midi_offset = 0;
     }
     
     void Instance::processPrints()
     {
-        std::string temp;
-        std::string print;
+        Print print;
         while(m_print_queue.try_dequeue(print))
         {
-            if(print.empty())
+            // The fragments of the lines printed by different threads can be
+            // dequeued interleaved, so they are gathered by line.
+            auto& pending = m_print_pending[print.line];
+            pending.first += print.text;
+            if(++pending.second < print.count)
             {
                 continue;
             }
-            else if(print.back() == '\n')
+            std::string temp = std::move(pending.first);
+            m_print_pending.erase(print.line);
+            if(m_print_mirror.load())
             {
-                while(print.back() == '\n' || print.back() == ' ') {
-                    print.pop_back();
-                }
-                temp += print;
-                receivePrint(temp);
-                temp.clear();
+                fputs(temp.c_str(), stderr);
+                fputc('\n', stderr);
             }
-            else
+            while(!temp.empty() && temp.back() == ' ')
             {
-                temp += print;
+                temp.pop_back();
             }
+            receivePrint(temp);
+        }
+        if(m_print_mirror.load())
+        {
+            fflush(stderr);
+        }
+        const size_t overflows = m_print_overflows.exchange(0);
+        if(overflows)
+        {
+            receivePrint("error: camomile print: " + std::to_string(overflows) + " messages dropped");
+        }
+        const size_t messages = m_message_overflows.exchange(0);
+        if(messages)
+        {
+            receivePrint("error: camomile: " + std::to_string(messages) + " messages from the patch dropped");
         }
     }
     
+    bool Instance::dequeueFile(std::string& path)
+    {
+        File file;
+        if(m_file_queue.try_dequeue(file))
+        {
+            path = file.path;
+            return true;
+        }
+        return false;
+    }
+    
+    void Instance::forgetFiles() noexcept
+    {
+        for(auto& hash : m_file_hashes)
+        {
+            hash.store(0);
+        }
+    }
+    
+    void Instance::setPrintMirror(const bool state) noexcept
+    {
+        m_print_mirror.store(state);
+    }
+    
     void Instance::enqueueMessages(const std::string& dest, const std::string& msg, std::vector<Atom>&& list)
     {
         m_send_queue.try_enqueue(dmessage{nullptr, dest, msg, std::move(list)});
@@ -387,57 +1032,65 @@ namespace pd
     void Instance::sendMessagesFromQueue()
     {
         libpd_set_instance(static_cast<t_pdinstance *>(m_instance));
-        dmessage mess;
-        while(m_send_queue.try_dequeue(mess))
+        m_send_time.store(std::chrono::steady_clock::now().time_since_epoch().count());
+        // The messages are dequeued by batches and a value sent to an object is
+        // dropped when the next message sets the value of the same object.
+        size_t count;
+        while((count = m_send_queue.try_dequeue_bulk(m_send_messages.begin(), m_send_messages.size())) > 0)
         {
-            if(mess.object && !mess.list.empty())
+            for(size_t j = 0; j < count; ++j)
             {
-                if(mess.selector == "list")
+                dmessage& mess = m_send_messages[j];
+                if(mess.object && j + 1 < count &&
+                   m_send_messages[j+1].object == mess.object && m_send_messages[j+1].selector == mess.selector)
                 {
-                    t_atom* argv = static_cast<t_atom*>(m_atoms);
-                    for(size_t i = 0; i < mess.list.size(); ++i)
-                    {
-                        if(mess.list[i].isFloat())
-                            SETFLOAT(argv+i, mess.list[i].getFloat());
-                        else if(mess.list[i].isSymbol())
-                        {
-                            sys_lock();
-                            SETSYMBOL(argv+i, gensym(mess.list[i].getSymbol().data()));
-                            sys_unlock();
-                        }
-                        else
-                            SETFLOAT(argv+i, 0.0);
-                    }
-                    sys_lock();
-                    pd_list(static_cast<t_pd *>(mess.object), gensym("list"), static_cast<int>(mess.list.size()), argv);
-                    sys_unlock();
+                    continue;
                 }
-                else if(mess.selector == "float" && mess.list[0].isFloat())
+                if(mess.object && !mess.list.empty())
                 {
-                    sys_lock();
-                    pd_float(static_cast<t_pd *>(mess.object), mess.list[0].getFloat());
-                    sys_unlock();
+                    // The instance is locked once per message unless the thread is within
+                    // a tick, the symbols are interned and the message is sent within the lock.
+                    if(mess.selector == "list")
+                    {
+                        std::vector<t_atom> heap(mess.list.size() > atoms_capacity ? mess.list.size() : 0);
+                        t_atom* argv = heap.empty() ? static_cast<t_atom*>(m_atoms) : heap.data();
+                        internal::lock_guard const lock(this);
+                        internal::set_atoms(argv, mess.list);
+                        pd_list(static_cast<t_pd *>(mess.object), &s_list, static_cast<int>(mess.list.size()), argv);
+                    }
+                    else if(mess.selector == "float" && mess.list[0].isFloat())
+                    {
+                        internal::lock_guard const lock(this);
+                        pd_float(static_cast<t_pd *>(mess.object), mess.list[0].getFloat());
+                    }
+                    else if(mess.selector == "symbol")
+                    {
+                        internal::lock_guard const lock(this);
+                        pd_symbol(static_cast<t_pd *>(mess.object), gensym(mess.list[0].getSymbol().c_str()));
+                    }
                 }
-                else if(mess.selector == "symbol")
+                else
                 {
-                    sys_lock();
-                    pd_symbol(static_cast<t_pd *>(mess.object), gensym(mess.list[0].getSymbol().c_str()));
-                    sys_unlock();
+                    sendMessage(mess.destination.c_str(), mess.selector.c_str(), mess.list);
                 }
             }
-            else
-            {
-                sendMessage(mess.destination.c_str(), mess.selector.c_str(), mess.list);
-            }
         }
     }
     
+    bool Instance::isSendingStalled() const noexcept
+    {
+        auto const now = std::chrono::steady_clock::now().time_since_epoch().count();
+        auto const interval = std::chrono::duration_cast<std::chrono::steady_clock::duration>(send_interval).count();
+        return now - m_send_time.load() > interval;
+    }
+    
     //////////////////////////////////////////////////////////////////////////////////////////
     //////////////////////////////////////////////////////////////////////////////////////////
     
     void Instance::openPatch(std::string const& path, std::string const& name)
     {
         closePatch();
+        forgetFiles();
         libpd_set_instance(static_cast<t_pdinstance *>(m_instance));
         m_patch = libpd_create_canvas(name.c_str(), path.c_str());
         
@@ -448,6 +1101,12 @@ namespace pd
         if(m_patch)
         {
             libpd_set_instance(static_cast<t_pdinstance *>(m_instance));
+            {
+                internal::lock_guard const lock(this);
+                m_gui_watched.clear();
+                ++m_gui_generation;
+                m_gui_watching.store(false);
+            }
             libpd_closefile(m_patch);
             m_patch = nullptr;
         }
@@ -458,6 +1117,116 @@ namespace pd
         return Patch(m_patch, this);
     }
     
+    void Instance::loadPatch(std::string const& path, std::string const& name)
+    {
+        internal::instance_free(m_pending);
+        internal::instance_create(this, m_pending);
+        if(m_params_size > 0)
+        {
+            m_pending.params_table = libpd_multi_params_new(m_params_size);
+        }
+        libpd_init_audio(m_dsp_inputs, m_dsp_outputs, (int)m_dsp_samplerate);
+        forgetFiles();
+        m_pending.patch = libpd_create_canvas(name.c_str(), path.c_str());
+        if(m_dsp_running)
+        {
+            t_atom av;
+            libpd_set_float(&av, 1.f);
+            libpd_message("pd", "dsp", 1, &av);
+        }
+        m_fade_buffer.assign(static_cast<size_t>(std::max(m_dsp_outputs, 1) * m_blocksize), 0.f);
+        m_fade_channels.resize(static_cast<size_t>(std::max(m_dsp_outputs, 0)));
+        libpd_set_instance(static_cast<t_pdinstance *>(m_instance));
+    }
+    
+    void Instance::sendPendingBang(const char* receiver) const
+    {
+        if(!m_pending.instance)
+        {
+            return;
+        }
+        libpd_set_instance(static_cast<t_pdinstance *>(m_pending.instance));
+        sys_lock();
+        if(t_pd* dest = internal::find(receiver))
+        {
+            pd_bang(dest);
+        }
+        sys_unlock();
+        libpd_set_instance(static_cast<t_pdinstance *>(m_instance));
+    }
+    
+    void Instance::sendPendingList(const char* receiver, const std::vector<Atom>& list) const
+    {
+        if(!m_pending.instance)
+        {
+            return;
+        }
+        // The preallocated atoms belong to the current instance that is still processed.
+        std::vector<t_atom> argv(list.size());
+        libpd_set_instance(static_cast<t_pdinstance *>(m_pending.instance));
+        sys_lock();
+        internal::set_atoms(argv.data(), list);
+        if(t_pd* dest = internal::find(receiver))
+        {
+            pd_list(dest, &s_list, static_cast<int>(list.size()), argv.data());
+        }
+        sys_unlock();
+        libpd_set_instance(static_cast<t_pdinstance *>(m_instance));
+    }
+    
+    bool Instance::swapPatch(const int fade)
+    {
+        if(!m_pending.instance)
+        {
+            return false;
+        }
+        libpd_set_instance(static_cast<t_pdinstance *>(m_instance));
+        {
+            internal::lock_guard const lock(this);
+            m_gui_watched.clear();
+            ++m_gui_generation;
+            m_gui_watching.store(false);
+        }
+        
+        m_previous = {m_instance, m_patch, m_message_receiver, m_midi_receiver, m_print_receiver, m_context, m_file_receiver, m_params_table};
+        m_instance          = m_pending.instance;
+        m_patch             = m_pending.patch;
+        m_message_receiver  = m_pending.message_receiver;
+        m_midi_receiver     = m_pending.midi_receiver;
+        m_print_receiver    = m_pending.print_receiver;
+        m_context           = m_pending.context;
+        m_file_receiver     = m_pending.file_receiver;
+        m_params_table      = m_pending.params_table;
+        m_pending = pinstance();
+        m_retired.store(m_previous.instance);
+        
+        m_fade_position = 0;
+        m_fade_length   = std::max(fade, 0);
+        m_fading.store(m_fade_length > 0);
+        libpd_set_instance(static_cast<t_pdinstance *>(m_instance));
+        m_dsp_time = clock_getlogicaltime();
+        return true;
+    }
+    
+    bool Instance::isFading() const noexcept
+    {
+        return m_fading.load();
+    }
+    
+    void Instance::stopFading() noexcept
+    {
+        m_fade_length = 0;
+        m_fade_position = 0;
+        m_fading.store(false);
+    }
+    
+    void Instance::releasePatch()
+    {
+        internal::instance_free(m_previous);
+        m_retired.store(nullptr);
+        libpd_set_instance(static_cast<t_pdinstance *>(m_instance));
+    }
+    
     //////////////////////////////////////////////////////////////////////////////////////////
     //////////////////////////////////////////////////////////////////////////////////////////
     
@@ -8,12 +8,18 @@
 
 #include <map>
 #include <utility>
+#include <atomic>
+#include <chrono>
 #include "PdPatch.hpp"
 #include "PdAtom.hpp"
 
 #include "../Queues/readerwriterqueue.h"
 #include "../Queues/concurrentqueue.h"
 
+#ifndef CAMOMILE_PRINT_STDERR
+#define CAMOMILE_PRINT_STDERR 1
+#endif
+
 namespace pd
 {
     class Patch;
@@ -29,12 +35,25 @@ namespace pd
         Instance(Instance const& other) = delete;
         virtual ~Instance();
         
-        void prepareDSP(const int nins, const int nouts, const double samplerate);
+        void prepareDSP(const int nins, const int nouts, const double samplerate, const int blocksize = 64);
         void startDSP();
         void releaseDSP();
-        void performDSP(float const* inputs, float* outputs);
+        void performDSP(float const** inputs, float** outputs, const int nins, const int nouts, const int nsamples);
         int getBlockSize() const noexcept;
         
+        //! @brief Locks the instance for a tick of the DSP.
+        //! @details Within the tick, the methods called by the thread that began it send the messages,
+        //! the MIDI events and the parameters and perform the DSP without locking the instance again,
+        //! so the instance is locked once per tick whatever the number of inputs. The tick must be
+        //! ended by the same thread and the patch must not be swapped within it.
+        void beginTick();
+        
+        //! @brief Unlocks the instance at the end of the tick.
+        void endTick();
+        
+        //! @brief Gets the number of times the methods of the instance locked it.
+        size_t getLockCount() const noexcept { return m_lock_count.load(); }
+        
         void sendNoteOn(const int channel, const int pitch, const int velocity) const;
         void sendControlChange(const int channel, const int controller, const int value) const;
         void sendProgramChange(const int channel, const int value) const;
@@ -44,6 +63,7 @@ namespace pd
         void sendSysEx(const int port, const int byte) const;
         void sendSysRealTime(const int port, const int byte) const;
         void sendMidiByte(const int port, const int byte) const;
+        void sendMidiMessages(unsigned char const* const* messages, int const* sizes, const int nmessages) const;
         
         virtual void receiveNoteOn(const int channel, const int pitch, const int velocity) {}
         virtual void receiveControlChange(const int channel, const int controller, const int value) {}
@@ -53,6 +73,14 @@ namespace pd
         virtual void receivePolyAftertouch(const int channel, const int pitch, const int value) {}
         virtual void receiveMidiByte(const int port, const int byte) {}
         
+        //! @brief Gets the position in samples of the MIDI event received within the last block.
+        //! @details The position is deduced from the logical time of Pd, so the events
+        //! scheduled by the clocks are sample accurate. It is only valid in the receive methods.
+        int getMidiOffset() const noexcept { return m_midi_offset; }
+        
+        void prepareParameters(const int size);
+        void sendParameterRamp(const int index, const float value, const float ramp) const;
+        
         void sendBang(const char* receiver) const;
         void sendFloat(const char* receiver, float const value) const;
         void sendSymbol(const char* receiver, const char* symbol) const;
@@ -74,31 +102,176 @@ namespace pd
         
         virtual void messageEnqueued() {};
         
+        //! @brief Sends the queued messages to Pd.
+        //! @details The consecutive value changes of a same object are coalesced.
         void sendMessagesFromQueue();
+        
+        //! @brief Gets if the queued messages have not been sent for a while.
+        //! @details The messages are sent by the audio thread at each tick, the other threads
+        //! only have to send them if the audio processing stalled.
+        bool isSendingStalled() const noexcept;
         void processMessages();
         void processPrints();
+        
+        //! @brief Sets if the messages printed by Pd are mirrored to the standard error.
+        //! @details The default state is defined by CAMOMILE_PRINT_STDERR.
+        void setPrintMirror(const bool state) noexcept;
+        
+        //! @brief Gets the next file opened by Pd.
+        //! @details The abstractions, the sound files and the texts read by the patch are
+        //! reported once by the thread that opens them, the files that don't fit in the queue are
+        //! reported again the next time they are opened.
+        bool dequeueFile(std::string& path);
         void processMidi();
         
+        //! @brief Gets the number of messages from Pd dropped because they didn't fit in the preallocated memory.
+        size_t getMessageOverflows() const noexcept { return m_message_overflows.load(); }
+        
+        //! @brief A value change of a watched GUI published by Pd.
+        //! @details The index refers to the GUI in the vector of the watch of the generation.
+        //! The symbol or the list of an atom GUI is copied in the text, truncated if needed,
+        //! so the receiver never reads the Pd object.
+        struct GuiValue
+        {
+            size_t index;
+            size_t generation;
+            float  value;
+            char   text[128];
+        };
+        
+        //! @brief Sets the GUIs whose value changes are published by Pd and returns the generation of the watch.
+        //! @details The values are compared within the DSP ticks at the GUI rate, so the GUIs don't have
+        //! to read the Pd objects and only the changes are published. The GUIs deleted by the patch
+        //! are no longer watched.
+        size_t watchGuis(std::vector<Gui> const& guis);
+        
+        //! @brief Publishes the value changes of the watched GUIs.
+        //! @details The method is called after the DSP ticks and must be called
+        //! by the thread that processes the messages when the DSP is not performed.
+        void publishGuis();
+        
+        //! @brief Gets the next value change of the watched GUIs.
+        bool dequeueGuiValue(GuiValue& value);
+        
         void openPatch(std::string const& path, std::string const& name);
         void closePatch();
         Patch getPatch();
+        
+        //! @brief Loads a patch in a new instance of Pd while the current one keeps processing.
+        //! @details The new instance is prepared like the current one and its receivers are bound
+        //! to this object. The method must not be called before the previous instance is released.
+        void loadPatch(std::string const& path, std::string const& name);
+        
+        //! @brief Sends a bang to the patch loaded in the new instance before it replaces the current one.
+        //! @details The method must be called by the thread that loaded the patch.
+        void sendPendingBang(const char* receiver) const;
+        
+        //! @brief Sends a list to the patch loaded in the new instance before it replaces the current one.
+        //! @details The method must be called by the thread that loaded the patch.
+        void sendPendingList(const char* receiver, const std::vector<Atom>& list) const;
+        
+        //! @brief Replaces the current instance by the one of the loaded patch.
+        //! @details The method must be called by the thread that performs the DSP between two blocks,
+        //! outside of a tick.
+        //! The previous instance processes the inputs until its outputs are crossfaded with the ones
+        //! of the new instance during a number of samples, it doesn't send messages anymore.
+        //! Returns false if no patch has been loaded.
+        bool swapPatch(const int fade);
+        
+        //! @brief Gets if the outputs of the previous instance are still crossfaded.
+        bool isFading() const noexcept;
+        
+        //! @brief Stops the crossfade, the DSP must not be performed concurrently.
+        void stopFading() noexcept;
+        
+        //! @brief Frees the previous instance, the crossfade must be over.
+        //! @details The messages queued by the previous instance refer to the names of its
+        //! symbols, so processMessages must be called between the swap and the release.
+        void releasePatch();
 
         void setThis();
         Array getArray(std::string const& name);
         
     private:
     
+        struct pcontext;
+        
         void* m_instance            = nullptr;
         void* m_patch               = nullptr;
         void* m_atoms               = nullptr;
         void* m_message_receiver    = nullptr;
         void* m_midi_receiver       = nullptr;
         void* m_print_receiver      = nullptr;
+        pcontext* m_context         = nullptr;
+        void* m_file_receiver       = nullptr;
+        void* m_params_table        = nullptr;
+        int   m_blocksize           = 64;
+        int   m_midi_offset         = 0;
+        double m_dsp_time           = 0.0;
+        std::string m_symbol;
+        int   m_params_size         = 0;
+        int   m_dsp_inputs          = 0;
+        int   m_dsp_outputs         = 0;
+        double m_dsp_samplerate     = 0.0;
+        bool  m_dsp_running         = false;
         
+        //! @brief The objects of an instance of Pd that is loaded or released.
+        struct pinstance
+        {
+            void* instance          = nullptr;
+            void* patch             = nullptr;
+            void* message_receiver  = nullptr;
+            void* midi_receiver     = nullptr;
+            void* print_receiver    = nullptr;
+            pcontext* context       = nullptr;
+            void* file_receiver     = nullptr;
+            void* params_table      = nullptr;
+        };
+        
+        pinstance                m_pending;
+        pinstance                m_previous;
+        std::atomic<void*>       m_retired {nullptr};
+        std::atomic<bool>        m_fading {false};
+        int                      m_fade_length   = 0;
+        int                      m_fade_position = 0;
+        std::vector<float>       m_fade_buffer;
+        std::vector<float*>      m_fade_channels;
+        
+        //! @brief An atom that refers to the name of an interned symbol of the instance.
+        struct iatom
+        {
+            char const* symbol;
+            float       value;
+        };
+        
+        static constexpr size_t atoms_capacity   = 512;
+        static constexpr size_t message_capacity = 4;
+        static constexpr size_t block_capacity   = 16;
+        static constexpr size_t block_number     = 512;
+        static constexpr size_t large_capacity   = 1024;
+        static constexpr size_t large_number     = 8;
+        
+        //! @brief A message slot that owns no memory.
+        //! @details Small messages are stored in the slot, bigger ones in a
+        //! small or a large block of the preallocated pool, and the ones that
+        //! don't fit are dropped and counted. The symbols are the names interned
+        //! by the instance of Pd that sent the message, so its messages must all
+        //! be processed before it is freed (see releasePatch).
         struct Message
         {
-            std::string       selector;
-            std::vector<Atom> list;
+            enum
+            {
+                BANG,
+                FLOAT,
+                SYMBOL,
+                LIST,
+                MESSAGE
+            } type;
+            char const* selector;
+            size_t      size;
+            size_t      block;
+            pcontext*   context;
+            iatom       atoms[message_capacity];
         };
         
         struct dmessage
@@ -124,14 +297,100 @@ namespace pd
             int  midi1;
             int  midi2;
             int  midi3;
+            int  offset;
         } midievent;
         
         typedef moodycamel::ConcurrentQueue<dmessage> message_queue;
         message_queue m_send_queue = message_queue(4096);
         
+        static constexpr size_t send_capacity = 256;
+        static constexpr std::chrono::milliseconds send_interval = std::chrono::milliseconds(50);
+        
+        std::vector<dmessage>    m_send_messages = std::vector<dmessage>(send_capacity);
+        std::atomic<std::chrono::steady_clock::rep> m_send_time {0};
+        mutable std::atomic<size_t> m_lock_count {0};
+        
         moodycamel::ConcurrentQueue<Message> m_message_queue = moodycamel::ConcurrentQueue<Message>(4096);
+        moodycamel::ConcurrentQueue<size_t> m_message_blocks = moodycamel::ConcurrentQueue<size_t>(block_number);
+        moodycamel::ConcurrentQueue<size_t> m_message_larges = moodycamel::ConcurrentQueue<size_t>(large_number);
+        std::vector<iatom>       m_message_pool;
+        std::vector<Atom>        m_message_list;
+        std::string              m_message_selector;
+        std::atomic<size_t>      m_message_overflows {0};
         moodycamel::ConcurrentQueue<midievent> m_midi_queue = moodycamel::ConcurrentQueue<midievent>(4096);
-        moodycamel::ConcurrentQueue<std::string> m_print_queue = moodycamel::ConcurrentQueue<std::string>(4096);
+        
+        static constexpr size_t print_capacity = 256;
+        static constexpr size_t print_number   = 1024;
+        static constexpr size_t print_length   = 4096;
+        static constexpr size_t print_fragments = (print_length + print_capacity - 2) / (print_capacity - 1);
+        
+        //! @brief A fragment of a line printed by Pd.
+        struct Print
+        {
+            size_t line;
+            size_t count;
+            char text[print_capacity];
+        };
+        
+        //! @brief The state of the hooks of an instance of Pd.
+        //! @details The current and the pending instances print concurrently
+        //! under their own locks, so each one assembles its lines apart. The
+        //! messages it queued are counted until they are processed.
+        struct pcontext
+        {
+            Instance*         owner;
+            std::vector<char> text = std::vector<char>(print_length);
+            size_t            size = 0;
+            std::vector<Print> fragments = std::vector<Print>(print_fragments);
+            std::atomic<size_t> messages {0};
+        };
+        
+        moodycamel::ConcurrentQueue<Print> m_print_queue = moodycamel::ConcurrentQueue<Print>(print_number);
+        std::atomic<size_t>      m_print_lines {0};
+        std::map<size_t, std::pair<std::string, size_t>> m_print_pending;
+        std::atomic<size_t>      m_print_overflows {0};
+        std::atomic<bool>        m_print_mirror {CAMOMILE_PRINT_STDERR != 0};
+        static constexpr size_t file_capacity = 1024;
+        static constexpr size_t file_number   = 256;
+        static constexpr size_t file_hashes   = 1024;
+        static constexpr uint64_t file_removed = 1;
+        
+        //! @brief The path of a file opened by Pd.
+        struct File
+        {
+            char path[file_capacity];
+        };
+        
+        //! @brief Forgets the files already reported, so the ones of a new patch are reported again.
+        void forgetFiles() noexcept;
+        
+        moodycamel::ConcurrentQueue<File> m_file_queue = moodycamel::ConcurrentQueue<File>(file_number);
+        std::vector<std::atomic<uint64_t>> m_file_hashes = std::vector<std::atomic<uint64_t>>(file_hashes);
+        
+        struct gwatch
+        {
+            Gui     gui;
+            float   value;
+            size_t  hash;
+            bool    published;
+            bool    alive;
+            void const* cls;
+        };
+        
+        static constexpr std::chrono::milliseconds gui_interval = std::chrono::milliseconds(20);
+        
+        //! @brief Stops watching the GUIs that Pd deleted.
+        void checkGuis();
+        
+        std::vector<gwatch>      m_gui_watched;
+        std::vector<void*>       m_gui_objects;
+        std::vector<char>        m_gui_found;
+        unsigned int             m_gui_deletions = 0;
+        bool                     m_gui_checked = false;
+        size_t                   m_gui_generation = 0;
+        std::atomic<std::chrono::steady_clock::rep> m_gui_time {0};
+        std::atomic<bool>        m_gui_watching {false};
+        moodycamel::ConcurrentQueue<GuiValue> m_gui_queue = moodycamel::ConcurrentQueue<GuiValue>(4096);
         
         struct internal;
     };
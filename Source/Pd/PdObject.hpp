@@ -52,6 +52,9 @@ namespace pd
         //! @brief The bounds of the Object.
         virtual std::array<int, 4> getBounds() const noexcept;
         
+        //! @brief The address of the Pd object that identifies the Object.
+        void const* getPointer() const noexcept { return m_ptr; }
+        
     protected:
         Object(void* ptr, void* patch, Instance* instance) noexcept;
         
@@ -7,12 +7,14 @@
 #include "PdPatch.hpp"
 #include "PdObject.hpp"
 #include "PdGui.hpp"
+#include "PdInstance.hpp"
 
 extern "C"
 {
 #include <z_libpd.h>
 #include <g_canvas.h>
 #include "x_libpd_multi.h"
+#include "x_libpd_extra_utils.h"
 }
 
 namespace pd
@@ -66,6 +68,15 @@ namespace pd
         }
         return std::vector<Gui>();
     }
+    
+    void Patch::setVisible(bool state) noexcept
+    {
+        if(m_ptr && m_instance)
+        {
+            m_instance->setThis();
+            libpd_canvas_set_visible(m_ptr, state ? 1 : 0);
+        }
+    }
 }
 
 
@@ -43,6 +43,11 @@ namespace pd
         
         //! @brief Gets the GUI objects of the patch.
         std::vector<Gui> getGuis() noexcept;
+        
+        //! @brief Maps the patch in Pd.
+        //! @details The objects of a graph on parent compute their bounds and their texts
+        //! in the coordinates of the patch only when it is mapped.
+        void setVisible(bool state) noexcept;
     private:
         Patch(void* ptr, Instance* instance) noexcept;
         
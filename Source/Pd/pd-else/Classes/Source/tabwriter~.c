@@ -57,6 +57,7 @@ static void tabwriter_set(t_tabwriter *x, t_symbol *s){
     else{
         x->x_buffer = buffer_init((t_class *)x, s, x->x_numchans, 0);
         buffer_setminsize(x->x_buffer, 2);
+        buffer_setwrite(x->x_buffer); // camomile
     }
 }
 
@@ -303,8 +304,10 @@ static void *tabwriter_new(t_symbol *s, int ac, t_atom *av){
     if(name != NULL){
         x->x_buffer = buffer_init((t_class *)x, name, chn_n, 0);
         t_buffer *c = x->x_buffer;
-        if(c) // set channels and array sizes
+        if(c){ // set channels and array sizes
             buffer_setminsize(x->x_buffer, 2);
+            buffer_setwrite(x->x_buffer); // camomile
+        }
     }
     x->x_numchans = chn_n;
     x->x_ivecs = getbytes(x->x_numchans * sizeof(*x->x_ivecs)); // allocate in vectors
@@ -13,7 +13,9 @@ t_word *buffer_get(t_buffer *c, t_symbol * name, int *bufsize, int indsp, int co
         if(ap){
             int bufsz;
             t_word *vec;
-            if(garray_getfloatwords(ap, &bufsz, &vec)){
+            // camomile: the readers don't copy the shared arrays
+            if(c->c_write ? garray_getfloatwords(ap, &bufsz, &vec) :
+               garray_readfloatwords(ap, &bufsz, &vec)){
                 if(indsp)
                     garray_usedindsp(ap);
                 if(bufsize)
@@ -233,12 +235,20 @@ void *buffer_init(t_class *owner, t_symbol *bufname, int numchans, int singlemod
     c->c_disabled = 0;
     c->c_playable = 0;
     c->c_minsize = 1;
+    c->c_write = 0;
     c->c_numchans = numchans;
     if(bufname != &s_)
         buffer_initarray(c, bufname, 0);
     return (c);
 }
 
+// camomile: the vectors are fetched again for writing
+void buffer_setwrite(t_buffer *c){
+    c->c_write = 1;
+    buffer_validate(c, 0);
+    buffer_playcheck(c);
+}
+
 void buffer_enable(t_buffer *c, t_floatarg f){
     c->c_disabled = (f == 0);
     buffer_playcheck(c);
@@ -26,6 +26,7 @@ typedef struct _buffer{
     int         c_single; //flag for single channel mode
                         //0-regular mode, 1-load this particular channel (1-idx)
                         //should be used with c_numchans == 1
+    int         c_write; // camomile: the owner writes the arrays
 }t_buffer;
 
 void buffer_bug(char *fmt, ...);
@@ -54,5 +55,7 @@ void buffer_free(t_buffer *c);
 //void buffer_setup(t_class *c, void *dspfn, void *floatfn);
 void buffer_checkdsp(t_buffer *c);
 void buffer_getchannel(t_buffer *c, int chan_num, int complain);
+// camomile: the arrays shared by the instances are copied before they are written
+void buffer_setwrite(t_buffer *c);
 
 #endif
@@ -9,6 +9,9 @@
 #include <m_imp.h>
 #include <g_canvas.h>
 #include <g_all_guis.h>
+#include <s_stuff.h>
+#include <string.h>
+#include <stdlib.h>
 
 // False GARRAY
 typedef struct _fake_garray
@@ -34,6 +37,87 @@ void* libpd_create_canvas(const char* name, const char* path)
     return cnv;
 }
 
+void libpd_canvas_set_visible(void* ptr, int state)
+{
+    sys_lock();
+    canvas_vis((t_canvas *)ptr, (t_floatarg)state);
+    sys_unlock();
+}
+
+void libpd_process_channels(int nticks, int nins, float const** inputs, int nouts, float** outputs)
+{
+    int i, j, offset;
+    int const pdins  = STUFF->st_inchannels;
+    int const pdouts = STUFF->st_outchannels;
+    size_t const nbytes = DEFDACBLKSIZE * sizeof(t_sample);
+    sys_pollgui();
+    for(i = 0, offset = 0; i < nticks; ++i, offset += DEFDACBLKSIZE)
+    {
+        for(j = 0; j < pdins; ++j)
+        {
+            if(j < nins)
+                memcpy(STUFF->st_soundin + j * DEFDACBLKSIZE, inputs[j] + offset, nbytes);
+            else
+                memset(STUFF->st_soundin + j * DEFDACBLKSIZE, 0, nbytes);
+        }
+        memset(STUFF->st_soundout, 0, pdouts * nbytes);
+        sched_tick();
+        for(j = 0; j < pdouts && j < nouts; ++j)
+        {
+            memcpy(outputs[j] + offset, STUFF->st_soundout + j * DEFDACBLKSIZE, nbytes);
+        }
+    }
+}
+
+void libpd_process_midi(int nmessages, unsigned char const* const* messages, int const* sizes)
+{
+    int i, j, n, status, channel;
+    unsigned char const* m;
+    for(i = 0; i < nmessages; ++i)
+    {
+        m = messages[i];
+        n = sizes[i];
+        if(n <= 0)
+        {
+            continue;
+        }
+        status  = m[0];
+        channel = status & 0x0F;
+        if(status >= 0x80 && status < 0xF0 && n >= 2)
+        {
+            switch(status & 0xF0)
+            {
+                case 0x80: if(n >= 3) { inmidi_noteon(0, channel, m[1] & 0x7F, 0); } break;
+                case 0x90: if(n >= 3) { inmidi_noteon(0, channel, m[1] & 0x7F, m[2] & 0x7F); } break;
+                case 0xA0: if(n >= 3) { inmidi_polyaftertouch(0, channel, m[1] & 0x7F, m[2] & 0x7F); } break;
+                case 0xB0: if(n >= 3) { inmidi_controlchange(0, channel, m[1] & 0x7F, m[2] & 0x7F); } break;
+                case 0xC0: inmidi_programchange(0, channel, m[1] & 0x7F); break;
+                case 0xD0: inmidi_aftertouch(0, channel, m[1] & 0x7F); break;
+                case 0xE0: if(n >= 3) { inmidi_pitchbend(0, channel, ((m[2] & 0x7F) << 7) | (m[1] & 0x7F)); } break;
+                default: break;
+            }
+        }
+        else if(status == 0xF0)
+        {
+            for(j = 1; j < n && m[j] != 0xF7; ++j)
+            {
+                inmidi_sysex(0, m[j]);
+            }
+        }
+        else if(status == 0xF8 || status == 0xFA || status == 0xFB || status == 0xFC || status == 0xFE || (status == 0xFF && n == 1))
+        {
+            for(j = 0; j < n; ++j)
+            {
+                inmidi_realtimein(0, m[j]);
+            }
+        }
+        for(j = 0; j < n; ++j)
+        {
+            inmidi_byte(0, m[j]);
+        }
+    }
+}
+
 char const* libpd_get_object_class_name(void* ptr)
 {
     return class_getname(pd_class((t_pd*)ptr));
@@ -99,6 +183,56 @@ int libpd_array_get_style(char const* name)
     return 0;
 }
 
+int libpd_array_get_changes(char const* name, unsigned int* version, int* size, int* from, int* to)
+{
+    int result = -1;
+    t_garray *array;
+    *size = 0; *from = 0; *to = 0;
+    sys_lock();
+    array = (t_garray *)libpd_array_get_byname(name);
+    if(array)
+    {
+        t_word *vec;
+        if(garray_readfloatwords(array, size, &vec))
+        {
+            *version = garray_getchanges(array, *version, from, to);
+            *from = *from < 0 ? 0 : (*from > *size ? *size : *from);
+            *to = *to < *from ? *from : (*to > *size ? *size : *to);
+            result = 0;
+        }
+    }
+    sys_unlock();
+    return result;
+}
+
+unsigned int libpd_get_deletions(void)
+{
+    return STUFF->st_deletions;
+}
+
+static int libpd_compare_objects(const void* a, const void* b)
+{
+    size_t const x = (size_t)(*(void* const*)a), y = (size_t)(*(void* const*)b);
+    return (x > y) - (x < y);
+}
+
+void libpd_canvas_find_objects(void* patch, int n, void* const* objects, char* found)
+{
+    t_gobj *y;
+    for(y = ((t_canvas *)patch)->gl_list; y; y = y->g_next)
+    {
+        void* const* result = (void* const*)bsearch(&y, objects, n, sizeof(void*), libpd_compare_objects);
+        if(result)
+        {
+            found[result - objects] = 1;
+        }
+        if(pd_class(&y->g_pd) == canvas_class)
+        {
+            libpd_canvas_find_objects(y, n, objects, found);
+        }
+    }
+}
+
 
 
 
@@ -14,6 +14,11 @@ extern "C"
     
 #include <z_libpd.h>
     void* libpd_create_canvas(const char* name, const char* path);
+    void libpd_canvas_set_visible(void* ptr, int state);
+    // The instance must be locked by the caller, so the DSP ticks and the MIDI events
+    // can be processed with the messages of a same tick.
+    void libpd_process_channels(int nticks, int nins, float const** inputs, int nouts, float** outputs);
+    void libpd_process_midi(int nmessages, unsigned char const* const* messages, int const* sizes);
     
     char const* libpd_get_object_class_name(void* ptr);
     void libpd_get_object_text(void* ptr, char** text, int* size);
@@ -23,6 +28,13 @@ extern "C"
     char const* libpd_array_get_name(void* ptr);
     void libpd_array_get_scale(char const* name, float* min, float* max);
     int libpd_array_get_style(char const* name);
+    // Gets the range modified since the version and updates the version.
+    int libpd_array_get_changes(char const* name, unsigned int* version, int* size, int* from, int* to);
+    
+    // The number of objects deleted from the canvases of the current instance.
+    unsigned int libpd_get_deletions(void);
+    // Marks the objects, sorted by address, that are still in the patch or its subpatches.
+    void libpd_canvas_find_objects(void* patch, int n, void* const* objects, char* found);
     
     unsigned int libpd_iemgui_get_background_color(void* ptr);
     unsigned int libpd_iemgui_get_foreground_color(void* ptr);
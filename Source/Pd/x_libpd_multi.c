@@ -274,6 +274,198 @@ void* libpd_multi_print_new(void* ptr, t_libpd_multi_printhook hook_print)
     return x;
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+static t_class *libpd_multi_file_class;
+
+typedef struct _libpd_multi_file
+{
+    t_object    x_obj;
+    void*       x_ptr;
+    t_libpd_multi_filehook x_hook;
+} t_libpd_multi_file;
+
+static void libpd_multi_file(const char* dir, const char* name)
+{
+    t_libpd_multi_file* x = (t_libpd_multi_file*)gensym("#libpd_multi_file")->s_thing;
+    if(x && x->x_hook)
+    {
+        x->x_hook(x->x_ptr, dir, name);
+    }
+}
+
+static void libpd_multi_file_setup(void)
+{
+    sys_lock();
+    libpd_multi_file_class = class_new(gensym("libpd_multi_file"), (t_newmethod)NULL, (t_method)NULL,
+                                       sizeof(t_libpd_multi_file), CLASS_DEFAULT, A_NULL, 0);
+    sys_unlock();
+}
+
+void* libpd_multi_file_new(void* ptr, t_libpd_multi_filehook hook_file)
+{
+    t_libpd_multi_file *x = (t_libpd_multi_file *)pd_new(libpd_multi_file_class);
+    if(x)
+    {
+        sys_lock();
+        t_symbol* s = gensym("#libpd_multi_file");
+        sys_unlock();
+        pd_bind(&x->x_obj.ob_pd, s);
+        x->x_ptr = ptr;
+        x->x_hook = hook_file;
+    }
+    return x;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+static t_class *libpd_multi_params_class;
+
+typedef struct _libpd_multi_param
+{
+    t_float     p_start;
+    t_float     p_end;
+    double      p_time;
+    double      p_ramp;
+} t_libpd_multi_param;
+
+typedef struct _libpd_multi_params
+{
+    t_object                x_obj;
+    int                     x_size;
+    t_libpd_multi_param*    x_params;
+} t_libpd_multi_params;
+
+static t_float libpd_multi_param_get(t_libpd_multi_param const* p, double elapsed)
+{
+    if(elapsed >= p->p_ramp)
+    {
+        return p->p_end;
+    }
+    if(elapsed <= 0)
+    {
+        return p->p_start;
+    }
+    return p->p_start + (p->p_end - p->p_start) * (t_float)(elapsed / p->p_ramp);
+}
+
+static void libpd_multi_params_free(t_libpd_multi_params *x)
+{
+    pd_unbind(&x->x_obj.ob_pd, gensym("#libpd_multi_params"));
+    freebytes(x->x_params, (size_t)x->x_size * sizeof(t_libpd_multi_param));
+}
+
+static void libpd_multi_params_setup(void)
+{
+    sys_lock();
+    libpd_multi_params_class = class_new(gensym("libpd_multi_params"), (t_newmethod)NULL, (t_method)libpd_multi_params_free,
+                                         sizeof(t_libpd_multi_params), CLASS_PD, A_NULL, 0);
+    sys_unlock();
+}
+
+void* libpd_multi_params_new(int size)
+{
+    t_libpd_multi_params *x = (t_libpd_multi_params *)pd_new(libpd_multi_params_class);
+    if(x)
+    {
+        sys_lock();
+        t_symbol* s = gensym("#libpd_multi_params");
+        sys_unlock();
+        pd_bind(&x->x_obj.ob_pd, s);
+        x->x_size   = size > 0 ? size : 0;
+        x->x_params = (t_libpd_multi_param *)getbytes((size_t)x->x_size * sizeof(t_libpd_multi_param));
+    }
+    return x;
+}
+
+void libpd_multi_params_set(void* ptr, int index, float value, float ramp)
+{
+    t_libpd_multi_params *x = (t_libpd_multi_params *)ptr;
+    if(x && index >= 0 && index < x->x_size)
+    {
+        t_libpd_multi_param* p = x->x_params + index;
+        p->p_start  = libpd_multi_param_get(p, clock_gettimesince(p->p_time));
+        p->p_end    = value;
+        p->p_time   = clock_getlogicaltime();
+        p->p_ramp   = ramp;
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+static t_class *libpd_multi_param_tilde_class;
+
+typedef struct _libpd_multi_param_tilde
+{
+    t_object                x_obj;
+    int                     x_index;
+    t_float                 x_sr;
+    t_libpd_multi_params*   x_params;
+} t_libpd_multi_param_tilde;
+
+static t_int *libpd_multi_param_tilde_perform(t_int *w)
+{
+    t_libpd_multi_param_tilde *x = (t_libpd_multi_param_tilde *)(w[1]);
+    t_sample *out = (t_sample *)(w[2]);
+    int const n = (int)(w[3]);
+    int i;
+    if(x->x_params && x->x_index >= 0 && x->x_index < x->x_params->x_size)
+    {
+        // the logical time is at the end of the tick during the DSP
+        t_libpd_multi_param const* p = x->x_params->x_params + x->x_index;
+        double const dt = 1000. / (double)x->x_sr;
+        double const elapsed = clock_gettimesince(p->p_time) - (double)n * dt;
+        for(i = 0; i < n; ++i)
+        {
+            out[i] = libpd_multi_param_get(p, elapsed + (double)i * dt);
+        }
+    }
+    else
+    {
+        for(i = 0; i < n; ++i)
+        {
+            out[i] = 0;
+        }
+    }
+    return (w+4);
+}
+
+static void libpd_multi_param_tilde_dsp(t_libpd_multi_param_tilde *x, t_signal **sp)
+{
+    t_pd* params = gensym("#libpd_multi_params")->s_thing;
+    x->x_params = (params && *params == libpd_multi_params_class) ? (t_libpd_multi_params *)params : NULL;
+    x->x_sr     = sp[0]->s_sr;
+    dsp_add(libpd_multi_param_tilde_perform, 3, x, sp[0]->s_vec, (t_int)sp[0]->s_n);
+}
+
+static void *libpd_multi_param_tilde_new(t_floatarg f)
+{
+    t_libpd_multi_param_tilde *x = (t_libpd_multi_param_tilde *)pd_new(libpd_multi_param_tilde_class);
+    if(x)
+    {
+        x->x_index  = (int)f - 1;
+        x->x_sr     = 44100;
+        x->x_params = NULL;
+        outlet_new(&x->x_obj, &s_signal);
+    }
+    return x;
+}
+
+static void libpd_multi_param_tilde_setup(void)
+{
+    sys_lock();
+    libpd_multi_param_tilde_class = class_new(gensym("param~"), (t_newmethod)libpd_multi_param_tilde_new, (t_method)NULL,
+                                              sizeof(t_libpd_multi_param_tilde), CLASS_NOINLET, A_DEFFLOAT, 0);
+    class_addmethod(libpd_multi_param_tilde_class, (t_method)libpd_multi_param_tilde_dsp, gensym("dsp"), A_CANT, 0);
+    sys_unlock();
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////////////////////////
@@ -576,6 +768,7 @@ void libpd_multi_init(void)
         libpd_set_polyaftertouchhook(libpd_multi_polyaftertouch);
         libpd_set_midibytehook(libpd_multi_midibyte);
         libpd_set_printhook(libpd_multi_print);
+        canvas_setopenhook(libpd_multi_file);
         
         libpd_set_verbose(0);
         libpd_init();
@@ -583,6 +776,9 @@ void libpd_multi_init(void)
         libpd_multi_receiver_setup();
         libpd_multi_midi_setup();
         libpd_multi_print_setup();
+        libpd_multi_file_setup();
+        libpd_multi_params_setup();
+        libpd_multi_param_tilde_setup();
         libpd_defaultfont_init();
         //libpd_set_verbose(4);
         
@@ -51,6 +51,13 @@ typedef void (*t_libpd_multi_printhook)(void* ptr, const char *recv);
 
 void* libpd_multi_print_new(void* ptr, t_libpd_multi_printhook hook_print);
 
+typedef void (*t_libpd_multi_filehook)(void* ptr, const char *dir, const char *name);
+
+void* libpd_multi_file_new(void* ptr, t_libpd_multi_filehook hook_file);
+
+void* libpd_multi_params_new(int size);
+void libpd_multi_params_set(void* ptr, int index, float value, float ramp);
+
 #ifdef __cplusplus
 }
 #endif
@@ -8,101 +8,168 @@
 #include <string>
 #include <utility>
 #include <vector>
-#include <mutex>
+#include <deque>
+#include <atomic>
+#include <algorithm>
 #include <cassert>
-#include <limits>
+
+#include "Queues/concurrentqueue.h"
 
 //! @brief A class that manages the console
+//! @details The messages can be added from any thread, they are queued without locking
+//! and moved to the history by the reader thread (the message thread) that owns it. The
+//! history is a ring buffer that evicts the oldest messages and each level has an index
+//! of the messages it displays so the rows are accessed in constant time.
 class CamomileConsole
 {
 public:
     public:
     using level_t = size_t;
     using message_t = std::pair<level_t, std::string>;
-    
+
     //! @brief the constructor.
     CamomileConsole(const level_t maxlevel, size_t const preallocate = 4096) :
     m_max_level(maxlevel),
-    m_counters(maxlevel, 0),
-    m_messages(preallocate)
+    m_queue(preallocate),
+    m_messages(std::max(preallocate, static_cast<size_t>(1))),
+    m_indices(maxlevel)
     {
-        m_messages.clear();
+
     }
-    
-    //! @brief Gets the number of all messages.
-    size_t size(level_t level) const noexcept
+
+    //! @brief Gets the number of messages until a level.
+    //! @details This method must be called by the reader thread.
+    size_t size(level_t level) noexcept
     {
         assert(level <= m_max_level && "wrong level of message");
-        if(m_mutex.try_lock())
-        {
-            size_t size = m_counters[level];
-            while (level--) { size += m_counters[level]; }
-            m_mutex.unlock();
-            return size;
-        }
-        return 0;
+        synchronize();
+        return m_indices[index(level)].size();
     }
-    
+
+    //! @brief Gets the revision of the history that changes when messages are added or removed.
+    //! @details This method must be called by the reader thread after size().
+    size_t getRevision() const noexcept
+    {
+        return m_revision;
+    }
+
     //! @brief Gets a message at an index until a level.
-    message_t get(level_t level, size_t index) const noexcept
+    //! @details This method must be called by the reader thread after size().
+    message_t const& get(level_t level, size_t row) const noexcept
     {
         assert(level <= m_max_level && "wrong level of message");
-        if(m_mutex.try_lock())
+        auto const& indices = m_indices[index(level)];
+        if(row < indices.size())
         {
-            for(size_t i = 0, c = 0; i < m_messages.size(); ++i)
-            {
-                if(m_messages[i].first <= level)
-                {
-                    if(c++ == index)
-                    {
-                        m_mutex.unlock();
-                        return m_messages[i];
-                    }
-                }
-            }
-            m_mutex.unlock();
+            return m_messages[indices[row] % m_messages.size()];
         }
-        return std::pair<size_t, std::string>();
+        return m_empty;
+    }
+
+    //! @brief Clears all the messages until a level.
+    //! @details This method must be called by the reader thread.
+    void clear(level_t level) noexcept
+    {
+        assert(level <= m_max_level && "wrong level of message");
+        auto const& indices = m_indices[index(level)];
+        std::vector<size_t> rows(indices.size());
+        for(size_t i = 0; i < rows.size(); ++i) { rows[i] = i; }
+        clear(level, rows);
     }
-    
-    //! @brief Clears the history.
-    void clear(level_t level, size_t index = std::numeric_limits<size_t>::max()) noexcept
+
+    //! @brief Clears the messages at the rows until a level.
+    //! @details This method must be called by the reader thread.
+    void clear(level_t level, std::vector<size_t> const& rows) noexcept
     {
-        std::lock_guard<std::mutex> guard(m_mutex);
-        size_t c = 0;
-        for(auto it = m_messages.begin(); it != m_messages.end(); ++it)
+        assert(level <= m_max_level && "wrong level of message");
+        auto const& indices = m_indices[index(level)];
+        std::vector<size_t> removed;
+        removed.reserve(rows.size());
+        for(auto row : rows)
         {
-            if(it->first <= level)
+            if(row < indices.size())
             {
-                if(c++ == index)
-                {
-                    --m_counters[it->first];
-                    m_messages.erase(it);
-                    return;
-                }
+                removed.push_back(indices[row]);
             }
         }
+        std::sort(removed.begin(), removed.end());
+        for(auto& current : m_indices)
+        {
+            current.erase(std::remove_if(current.begin(), current.end(), [&removed](size_t const i) {
+                return std::binary_search(removed.begin(), removed.end(), i); }), current.end());
+        }
+        ++m_revision;
     }
 
-    
     //! @brief Adds a message to the history.
+    //! @details This method can be called by any thread.
     void add(level_t level, std::string message) noexcept
     {
         assert(level < m_max_level && "wrong level of message");
-        if(m_mutex.try_lock())
+        if(!m_queue.try_enqueue(message_t{level, std::move(message)}))
         {
-            if(m_messages.size() < m_messages.capacity())
+            ++m_overflows;
+        }
+    }
+
+    //! @brief Moves the queued messages to the history and evicts the oldest ones.
+    //! @details This method must be called by the reader thread, regularly, so the queue
+    //! doesn't fill up when no one reads the history.
+    void synchronize()
+    {
+        message_t message;
+        while(m_queue.try_dequeue(message))
+        {
+            push(std::move(message));
+        }
+        const size_t overflows = m_overflows.exchange(0);
+        if(overflows)
+        {
+            push(message_t{std::min(static_cast<level_t>(1), m_max_level - 1),
+                "console: " + std::to_string(overflows) + " messages dropped"});
+        }
+    }
+
+private:
+
+    size_t index(level_t level) const noexcept
+    {
+        return std::min(level, m_max_level - 1);
+    }
+
+    void push(message_t&& message)
+    {
+        const size_t capacity = m_messages.size();
+        if(m_next - m_first == capacity)
+        {
+            // The indices are sorted, so the oldest message is at the
+            // front of the indices of the levels that contain it.
+            for(auto& indices : m_indices)
             {
-                ++m_counters[level];
-                m_messages.push_back(message_t{level, std::move(message)});
+                if(!indices.empty() && indices.front() == m_first)
+                {
+                    indices.pop_front();
+                }
             }
-            m_mutex.unlock();
+            ++m_first;
+        }
+        const size_t level = std::min(message.first, m_max_level - 1);
+        m_messages[m_next % capacity] = std::move(message);
+        for(size_t i = level; i < m_indices.size(); ++i)
+        {
+            m_indices[i].push_back(m_next);
         }
+        ++m_next;
+        ++m_revision;
     }
-    
-private:
-    mutable std::mutex          m_mutex;
-    const level_t               m_max_level;
-    std::vector<level_t>        m_counters;
-    std::vector<message_t>      m_messages;
+
+    const level_t                           m_max_level;
+    moodycamel::ConcurrentQueue<message_t>  m_queue;
+    std::atomic<size_t>                     m_overflows {0};
+    std::vector<message_t>                  m_messages;
+    std::vector<std::deque<size_t>>         m_indices;
+    size_t                                  m_first = 0;
+    size_t                                  m_next  = 0;
+    size_t                                  m_revision = 0;
+    message_t                               m_empty;
 };
@@ -31,14 +31,22 @@ AudioProcessorEditor (&p), CamomileEditorInteractionManager(p), m_processor (p),
     startTimer(25);
 }
 
-CamomileEditor::~CamomileEditor() {}
+CamomileEditor::~CamomileEditor()
+{
+    m_processor.watchGuis({});
+}
 
 void CamomileEditor::timerCallback()
 {
     CamomileEditorMessageManager::processMessages();
-    if(m_patch != nullptr)
+    pd::Instance::GuiValue change;
+    while(m_processor.dequeueGuiValue(change))
     {
-        m_patch->updateObjectsValues();
+        // The changes of a previous watch refer to objects that might not exist anymore.
+        if(change.generation == m_watched_generation && change.index < m_watched.size())
+        {
+            m_watched[change.index]->receiveValue(change.value, change.text);
+        }
     }
 }
 
@@ -107,6 +115,12 @@ void CamomileEditor::guiRedraw()
     {
         m_patch->updateObjects();
     }
+    updateWatchedObjects();
+}
+
+void CamomileEditor::guiCreated()
+{
+    updateWatchedObjects();
 }
 
 void CamomileEditor::reloadPatch()
@@ -118,4 +132,21 @@ void CamomileEditor::reloadPatch()
         m_patch->setTopLeftPosition(0, 0);
         addAndMakeVisible(m_patch.get());
     }
+    updateWatchedObjects();
+}
+
+void CamomileEditor::updateWatchedObjects()
+{
+    std::vector<pd::Gui> guis;
+    m_watched.clear();
+    if(m_patch)
+    {
+        m_patch->collectObjects(m_watched);
+    }
+    guis.reserve(m_watched.size());
+    for(auto* object : m_watched)
+    {
+        guis.push_back(object->getGUI());
+    }
+    m_watched_generation = m_processor.watchGuis(guis);
 }
@@ -29,16 +29,22 @@ public:
     
     void guiResize() final;
     void guiRedraw() final;
+    void guiCreated() final;
     
     void reloadPatch();
 private:
     
+    //! @brief Sets the objects whose value changes are published by Pd.
+    void updateWatchedObjects();
+    
     using object_uptr = std::unique_ptr<PluginEditorObject>;
     using label_uptr = std::unique_ptr<Component>;
     using object_pair = std::pair<object_uptr, label_uptr>;
     
     CamomileAudioProcessor&         m_processor;
     std::unique_ptr<GuiPatch>       m_patch;
+    std::vector<PluginEditorObject*> m_watched;
+    size_t                          m_watched_generation = 0;
     CamomileEditorButton            m_button;
     DrawableImage                   m_image;
     
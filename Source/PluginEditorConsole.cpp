@@ -87,19 +87,16 @@ void PluginEditorConsole::clearSelection()
     SparseSet<int> const selection = m_table.getSelectedRows();
     if(selection.isEmpty())
     {
-        const size_t n = m_history.size(m_level);
-        for(size_t i = n; i > 0; --i)
-        {
-            m_history.clear(m_level, i-1);
-        }
+        m_history.clear(m_level);
     }
     else
     {
-        const int n = selection.size();
-        for(int i = n; i > 0; --i)
+        std::vector<size_t> rows(static_cast<size_t>(selection.size()));
+        for(size_t i = 0; i < rows.size(); ++i)
         {
-            m_history.clear(m_level, static_cast<size_t>(selection[i-1]));
+            rows[i] = static_cast<size_t>(selection[static_cast<int>(i)]);
         }
+        m_history.clear(m_level, rows);
     }
     m_table.deselectAllRows();
     timerCallback();
@@ -235,7 +232,7 @@ void PluginEditorConsole::buttonClicked(Button* button)
 
 void PluginEditorConsole::paintListBoxItem(int rowNumber, Graphics& g, int width, int height, bool rowIsSelected)
 {
-    std::pair<size_t, std::string> const message(m_history.get(m_level, rowNumber));
+    auto const& message = m_history.get(m_level, static_cast<size_t>(rowNumber));
     if(rowIsSelected)
     {
         g.setColour(Colours::black);
@@ -267,10 +264,13 @@ void PluginEditorConsole::timerCallback()
 {
     m_history.processPrints();
     const size_t size = m_history.size(m_level);
-    if(m_size != size)
+    const size_t revision = m_history.getRevision();
+    if(m_size != size || m_revision != revision)
     {
         m_size = size;
+        m_revision = revision;
         m_table.updateContent();
+        m_table.repaint();
     }
 }
 
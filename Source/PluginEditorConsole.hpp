@@ -33,6 +33,7 @@ private:
     typedef CamomileAudioProcessor::ConsoleLevel ConsoleLevel;
     CamomileAudioProcessor& m_history;
     size_t                  m_size = 0;
+    size_t                  m_revision = 0;
     ListBox                 m_table;
     ConsoleLevel            m_level = ConsoleLevel::Normal;
     std::unique_ptr<Button>   m_level_button;
@@ -56,8 +56,11 @@ class CamomileEditorMouseManager
 {
 public:
     CamomileEditorMouseManager(CamomileAudioProcessor& processor) : m_processor(processor) {}
+    virtual ~CamomileEditorMouseManager() = default;
     void startEdition();
     void stopEdition();
+    //! @brief Notifies that GUI objects have been created after the patch has been loaded.
+    virtual void guiCreated() {}
     
     CamomileAudioProcessor& getProcessor() { return m_processor; }
 private:
@@ -7,6 +7,8 @@
 #include "PluginEditorObject.hpp"
 #include "PluginLookAndFeel.hpp"
 #include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
 
 //////////////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////     PATCH              ////////////////////////////
@@ -21,20 +23,34 @@ GuiPatch::GuiPatch(CamomileEditorMouseManager& processor, pd::Patch patch) : m_p
 
 void GuiPatch::updateObjects()
 {
+    // The objects are matched with the GUIs using the addresses of the Pd objects.
     auto guis = m_patch.getGuis();
+    std::unordered_set<void const*> current;
+    current.reserve(guis.size());
+    for(auto const& gui : guis)
+    {
+        current.insert(gui.getPointer());
+    }
     auto isObjectDeprecated = [&](object_pair const& pair)
     {
-        return pair.first != nullptr && std::find(guis.begin(), guis.end(), pair.first->getGUI()) == guis.end();
+        return pair.first != nullptr && current.count(pair.first->getGUI().getPointer()) == 0;
     };
     m_objects.erase(std::remove_if(m_objects.begin(), m_objects.end(), isObjectDeprecated), m_objects.end());
     
+    std::unordered_map<void const*, size_t> indices;
+    indices.reserve(m_objects.size());
+    for(size_t i = 0; i < m_objects.size(); ++i)
+    {
+        if(m_objects[i].first != nullptr)
+        {
+            indices.emplace(m_objects[i].first->getGUI().getPointer(), i);
+        }
+    }
+    
     for(auto& gui : guis)
     {
-        auto it = std::find_if(m_objects.begin(), m_objects.end(), [&gui](object_pair const& pair)
-                               {
-            return pair.first != nullptr && pair.first->getGUI() == gui;
-        });
-        if(it == m_objects.end())
+        auto const index = indices.find(gui.getPointer());
+        if(index == indices.end())
         {
             object_uptr object(PluginEditorObject::createTyped(m_processor, gui));
             if(object != nullptr)
@@ -50,8 +66,20 @@ void GuiPatch::updateObjects()
         }
         else
         {
+            auto const it = m_objects.begin() + static_cast<std::ptrdiff_t>(index->second);
             it->first->updateInterface();
             auto label = it->first->getLabel();
+            // The label is only replaced if it changed so the ones
+            // of the other objects are not repainted.
+            auto const& previous = it->second;
+            if(label != nullptr && previous != nullptr &&
+               label->getText() == previous->getText() &&
+               label->getBounds() == previous->getBounds() &&
+               label->getFont() == previous->getFont() &&
+               label->findColour(Label::textColourId) == previous->findColour(Label::textColourId))
+            {
+                continue;
+            }
             if(label != nullptr)
             {
                 addAndMakeVisible(label.get());
@@ -69,13 +97,13 @@ void GuiPatch::updateSize()
     setSize(width, height);
 }
 
-void GuiPatch::updateObjectsValues()
+void GuiPatch::collectObjects(std::vector<PluginEditorObject*>& objects)
 {
     for(auto const& object : m_objects)
     {
         if(object.first != nullptr)
         {
-            object.first->updateValue();
+            object.first->collectObjects(objects);
         }
     }
 }
@@ -203,13 +231,56 @@ void PluginEditorObject::updateValue()
     }
 }
 
+void PluginEditorObject::receiveValue(float v, char const*)
+{
+    if(edited == false && v != value)
+    {
+        value = v;
+        repaint();
+    }
+}
+
+void PluginEditorObject::collectObjects(std::vector<PluginEditorObject*>& objects)
+{
+    auto const type = gui.getType();
+    if(type != pd::Gui::Type::Undefined && type != pd::Gui::Type::Comment &&
+       type != pd::Gui::Type::Panel && type != pd::Gui::Type::Array)
+    {
+        objects.push_back(this);
+    }
+}
+
 void PluginEditorObject::updateInterface()
 {
-    min = gui.getMinimum();
-    max = gui.getMaximum();
+    // The bounds repaint the object when they change, the
+    // other properties only when one of them changed.
+    auto const nmin = gui.getMinimum();
+    auto const nmax = gui.getMaximum();
+    auto const nbackground = gui.getBackgroundColor();
+    auto const nforeground = gui.getForegroundColor();
+    auto const nfont_height = gui.getFontHeight();
+    auto const nlog_scale = gui.isLogScale();
+    bool const changed = nmin != min || nmax != max || nbackground != background ||
+    nforeground != foreground || nfont_height != font_height || nlog_scale != log_scale;
+    min = nmin;
+    max = nmax;
+    background = nbackground;
+    foreground = nforeground;
+    font_height = nfont_height;
+    log_scale = nlog_scale;
+    setOpaque(fills_background && (background >> 24) == 0xFF);
     std::array<int, 4> const bounds(gui.getBounds());
     setBounds(bounds[0], bounds[1], bounds[2], bounds[3]);
-    repaint();
+    if(changed)
+    {
+        repaint();
+    }
+}
+
+void PluginEditorObject::setFillsBackground(bool state)
+{
+    fills_background = state;
+    setOpaque(fills_background && (background >> 24) == 0xFF);
 }
 
 std::unique_ptr<Label> PluginEditorObject::getLabel()
@@ -236,6 +307,7 @@ std::unique_ptr<Label> PluginEditorObject::getLabel()
         label->setEditable(false, false);
         label->setInterceptsMouseClicks(false, false);
         label->setColour(Label::textColourId, Colour(static_cast<uint32>(lbl.getColor())));
+        label->setBufferedToImage(true);
         return label;
     }
     return nullptr;
@@ -558,6 +630,7 @@ void GuiRadioVertical::mouseDown(const MouseEvent& e)
 GuiPanel::GuiPanel(CamomileEditorMouseManager& p, pd::Gui& g) : PluginEditorObject(p, g)
 {
     //setInterceptsMouseClicks(false, false);
+    setFillsBackground(true);
     edited = true;
 }
 
@@ -591,19 +664,33 @@ void GuiPanel::mouseExit(const MouseEvent& e)
 ////////////////////////////////////     COMMENT             /////////////////////////////
 //////////////////////////////////////////////////////////////////////////////////////////
 
-GuiComment::GuiComment(CamomileEditorMouseManager& p, pd::Gui& g) : PluginEditorObject(p, g)
+GuiComment::GuiComment(CamomileEditorMouseManager& p, pd::Gui& g) : PluginEditorObject(p, g), m_text(g.getText())
 {
+    // The text layout is costly and the comment never changes
+    // with the values, so it is rendered once in an image.
     setInterceptsMouseClicks(false, false);
+    setBufferedToImage(true);
     edited = true;
 }
 
+void GuiComment::updateInterface()
+{
+    PluginEditorObject::updateInterface();
+    auto text = gui.getText();
+    if(text != m_text)
+    {
+        m_text = std::move(text);
+        repaint();
+    }
+}
+
 void GuiComment::paint(Graphics& g)
 {
     const auto fheight = gui.getFontHeight();
     auto const ft = CamoLookAndFeel::getFont(gui.getFontName()).withPointHeight(fheight);
     g.setFont(ft);
     g.setColour(juce::Colour(static_cast<uint32>(gui.getBackgroundColor())));
-    g.drawMultiLineText(gui.getText(), 0, static_cast<int>(ft.getAscent()), getWidth());
+    g.drawMultiLineText(m_text, 0, static_cast<int>(ft.getAscent()), getWidth());
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////
@@ -667,6 +754,15 @@ void GuiTextEditor::updateValue()
     }
 }
 
+void GuiTextEditor::receiveValue(float v, char const*)
+{
+    if(edited == false && !label.isBeingEdited() && v != value)
+    {
+        value = v;
+        label.setText(juce::String(value), juce::NotificationType::dontSendNotification);
+    }
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////     NUMBER              /////////////////////////////
 //////////////////////////////////////////////////////////////////////////////////////////
@@ -847,13 +943,12 @@ GuiAtomSymbol::GuiAtomSymbol(CamomileEditorMouseManager& p, pd::Gui& g) : GuiTex
 {
     label.onEditorHide = [this]()
     {
-        auto const strval = label.getText().toStdString();
-        if(strval != gui.getSymbol())
+        auto const strval = label.getText();
+        if(strval != published)
         {
             startEdition();
-            gui.setSymbol(strval);
+            gui.setSymbol(strval.toStdString());
             stopEdition();
-            label.setText(juce::String(gui.getSymbol()), juce::NotificationType::dontSendNotification);
         }
     };
     
@@ -891,9 +986,15 @@ void GuiAtomSymbol::paint(juce::Graphics& g)
 
 void GuiAtomSymbol::updateValue()
 {
+    // The symbol is only read by Pd, the text is received when it is published.
+}
+
+void GuiAtomSymbol::receiveValue(float, char const* text)
+{
+    published = juce::String::fromUTF8(text);
     if(edited == false && !label.isBeingEdited())
     {
-        label.setText(juce::String(gui.getSymbol()), juce::NotificationType::dontSendNotification);
+        label.setText(published, juce::NotificationType::dontSendNotification);
     }
 }
 
@@ -916,12 +1017,11 @@ GuiAtomList::GuiAtomList(CamomileEditorMouseManager& p, pd::Gui& g) : GuiTextEdi
                 list.push_back({elem.toStdString()});
             }
         }
-        if(list != gui.getList())
+        if(label.getText() != published)
         {
             startEdition();
             gui.setList(list);
             stopEdition();
-            label.setText(juce::String(gui.getSymbol()), juce::NotificationType::dontSendNotification);
         }
     };
     
@@ -960,26 +1060,15 @@ void GuiAtomList::paint(juce::Graphics& g)
 
 void GuiAtomList::updateValue()
 {
+    // The list is only read by Pd, the text is received when it is published.
+}
+
+void GuiAtomList::receiveValue(float, char const* text)
+{
+    published = juce::String::fromUTF8(text);
     if(edited == false && !label.isBeingEdited())
     {
-        auto const array = gui.getList();
-        juce::String message;
-        for(auto const& atom : array)
-        {
-            if(message.isNotEmpty())
-            {
-                message += " ";
-            }
-            if(atom.isFloat())
-            {
-                message += juce::String(atom.getFloat());
-            }
-            else if(atom.isSymbol())
-            {
-                message += juce::String(atom.getSymbol());
-            }
-        }
-        label.setText(message, juce::NotificationType::dontSendNotification);
+        label.setText(published, juce::NotificationType::dontSendNotification);
     }
 }
 
@@ -1000,28 +1089,51 @@ void GuiArray::resized()
 ////////////////////////////////////     GOP               /////////////////////////////
 //////////////////////////////////////////////////////////////////////////////////////////
 
-GuiGraphOnParent::GuiGraphOnParent(CamomileEditorMouseManager& p, pd::Gui& g) : PluginEditorObject(p, g), m_patch(p, g.getPatch())
+GuiGraphOnParent::GuiGraphOnParent(CamomileEditorMouseManager& p, pd::Gui& g) : PluginEditorObject(p, g)
 {
     setInterceptsMouseClicks(false, true);
     edited = true;
-    addAndMakeVisible(m_patch);
 }
 
 void GuiGraphOnParent::paint(Graphics& g)
 {
+    // The content is only created when the graph is in the clip region of the
+    // editor, so the graphs that are never displayed are not mapped in Pd.
+    if(m_patch == nullptr)
+    {
+        triggerAsyncUpdate();
+    }
     g.setColour(Colours::black);
     g.drawRect(getLocalBounds(), 1);
 }
 
-void GuiGraphOnParent::updateValue()
+void GuiGraphOnParent::handleAsyncUpdate()
+{
+    if(m_patch == nullptr)
+    {
+        auto graph = gui.getPatch();
+        graph.setVisible(true);
+        m_patch = std::make_unique<GuiPatch>(patch, graph);
+        addAndMakeVisible(m_patch.get());
+        patch.guiCreated();
+    }
+}
+
+void GuiGraphOnParent::collectObjects(std::vector<PluginEditorObject*>& objects)
 {
-    m_patch.updateObjectsValues();
+    if(m_patch != nullptr)
+    {
+        m_patch->collectObjects(objects);
+    }
 }
 
 void GuiGraphOnParent::updateInterface()
 {
     PluginEditorObject::updateInterface();
-    m_patch.updateObjects();
+    if(m_patch != nullptr)
+    {
+        m_patch->updateObjects();
+    }
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////
@@ -1031,10 +1143,12 @@ void GuiGraphOnParent::updateInterface()
 GraphicalArray::GraphicalArray(CamomileAudioProcessor& processor, pd::Array& graph) :
 m_processor(processor), m_array(graph), m_edited(false)
 {
+    size_t size, from, to;
     m_vector.reserve(8192);
-    m_temp.reserve(8192);
+    m_error = !m_array.getChanges(m_version, size, from, to);
     try { m_array.read(m_vector); }
     catch(...) { m_error = true; }
+    updatePeaks(0, m_vector.size());
     startTimer(100);
     setInterceptsMouseClicks(true, false);
     setOpaque(false);
@@ -1048,14 +1162,14 @@ void GraphicalArray::paint(Graphics& g)
         g.drawText("array " + m_array.getName() + " is invalid", 0, 0, getWidth(), getHeight(), juce::Justification::centred);
         return;
     }
-    if(m_vector.empty())
+    if(m_vector.empty() || m_minimums.size() != static_cast<size_t>(getWidth()))
     {
         return;
     }
     
     auto const height = static_cast<float>(getHeight());
     auto const width = static_cast<float>(getWidth());
-    auto const clipBounds = g.getClipBounds();
+    auto const clipBounds = g.getClipBounds().getIntersection(getLocalBounds());
     auto const scale = m_array.getScale();
     auto const dh = height / (scale[1] - scale[0]);
     auto const wRadio = static_cast<float>(m_vector.size()) / width;
@@ -1083,14 +1197,11 @@ void GraphicalArray::paint(Graphics& g)
         for(int i = clipBounds.getX(); i < clipBounds.getRight(); i++)
         {
             auto const x1 = static_cast<float>(i);
-            auto const currentIndex = static_cast<size_t>(x1 * wRadio);
-            auto const nextIndex = static_cast<size_t>((x1 + 1.0f) * wRadio);
-            auto const max = std::max_element(m_vector.cbegin()+currentIndex, m_vector.cbegin()+nextIndex, [](float const lhs, float const rhs) { return std::abs(lhs) < std::abs(rhs); });
-            if(max != m_vector.cend())
-            {
-                auto const y = std::floor(height - (*max - scale[0]) * dh);
-                p.lineTo(x1, y);
-            }
+            auto const min = m_minimums[static_cast<size_t>(i)];
+            auto const max = m_maximums[static_cast<size_t>(i)];
+            auto const value = std::abs(min) > std::abs(max) ? min : max;
+            auto const y = std::floor(height - (value - scale[0]) * dh);
+            p.lineTo(x1, y);
         }
         g.strokePath(p, juce::PathStrokeType(1));
     }
@@ -1100,15 +1211,9 @@ void GraphicalArray::paint(Graphics& g)
         for(int i = clipBounds.getX(); i < clipBounds.getRight(); i++)
         {
             auto const x1 = static_cast<float>(i);
-            auto const currentIndex = static_cast<size_t>(x1 * wRadio);
-            auto const nextIndex = static_cast<size_t>((x1 + 1.0f) * wRadio);
-            auto const minmax = std::minmax_element(m_vector.cbegin()+currentIndex, m_vector.cbegin()+nextIndex);
-            if(minmax.first != m_vector.cend() && minmax.first != m_vector.cend())
-            {
-                auto const y1 = std::floor(height - (*minmax.second - scale[0]) * dh);
-                auto const y2 = std::floor(height - (*minmax.first - scale[0]) * dh);
-                rectangles.add(x1, y1, 1.0f , std::max(y2 - y1, 1.0f));
-            }
+            auto const y1 = std::floor(height - (m_maximums[static_cast<size_t>(i)] - scale[0]) * dh);
+            auto const y2 = std::floor(height - (m_minimums[static_cast<size_t>(i)] - scale[0]) * dh);
+            rectangles.add(x1, y1, 1.0f , std::max(y2 - y1, 1.0f));
         }
         g.fillRectList(rectangles);
     }
@@ -1137,6 +1242,8 @@ void GraphicalArray::mouseDrag(const MouseEvent& event)
     const std::array<float, 2> scale = m_array.getScale();
     const size_t index = static_cast<size_t>(std::round(clip(x / w, 0.f, 1.f) * s));
     m_vector[index] = (1.f - clip(y / h, 0.f, 1.f)) * (scale[1] - scale[0]) + scale[0];
+    updatePeaks(index, index + 1);
+    updateSummary(index, index + 1);
     const CriticalSection& cs = m_processor.getCallbackLock();
     if(cs.tryEnter())
     {
@@ -1159,15 +1266,135 @@ void GraphicalArray::timerCallback()
 {
     if(!m_edited)
     {
-        m_error = false;
-        try { m_array.read(m_temp); }
-        catch(...) { m_error = true; }
-        if(m_temp != m_vector)
+        // Only the range of the array modified since the last version
+        // read is copied and the pixels that display it repainted.
+        size_t size, from, to;
+        bool const wasError = m_error;
+        m_error = !m_array.getChanges(m_version, size, from, to);
+        if(m_error)
         {
-            m_vector.swap(m_temp);
-            repaint();
+            if(!wasError)
+            {
+                repaint();
+            }
+            return;
+        }
+        if(wasError || size != m_vector.size())
+        {
+            m_vector.resize(size);
+            from = 0;
+            to   = size;
+        }
+        if(from < to)
+        {
+            m_array.read(m_vector, from, to);
+            updatePeaks(from, to);
+            if(from == 0 && to == size)
+            {
+                resized();
+                repaint();
+            }
+            else
+            {
+                auto const pixels = updateSummary(from, to);
+                repaint(pixels.getStart(), 0, pixels.getLength(), getHeight());
+            }
+        }
+    }
+}
+
+void GraphicalArray::resized()
+{
+    m_minimums.resize(static_cast<size_t>(std::max(getWidth(), 0)));
+    m_maximums.resize(m_minimums.size());
+    updateSummary(0, m_vector.size());
+}
+
+void GraphicalArray::updatePeaks(size_t from, size_t to)
+{
+    // The level l contains the minimum and the maximum of the blocks of 2^(l+1) values
+    // of the array, each level is built from the previous one so only the blocks that
+    // contain the modified range are recomputed.
+    auto const size = m_vector.size();
+    size_t nlevels = 0;
+    for(size_t s = size; s > 1; s = (s + 1) / 2) { ++nlevels; }
+    if(m_peaks.size() != nlevels || (nlevels && m_peaks[0].size() != (size + 1) / 2))
+    {
+        m_peaks.resize(nlevels);
+        for(size_t l = 0, s = (size + 1) / 2; l < nlevels; ++l, s = (s + 1) / 2)
+        {
+            m_peaks[l].resize(s);
+        }
+        from = 0;
+        to   = size;
+    }
+    to = std::min(to, size);
+    for(size_t l = 0; l < nlevels && from < to; ++l)
+    {
+        from >>= 1;
+        to = (to + 1) >> 1;
+        auto& level = m_peaks[l];
+        for(size_t j = from; j < to; ++j)
+        {
+            if(l == 0)
+            {
+                auto const a = m_vector[j * 2];
+                auto const b = j * 2 + 1 < size ? m_vector[j * 2 + 1] : a;
+                level[j] = std::minmax(a, b);
+            }
+            else
+            {
+                auto const& previous = m_peaks[l - 1];
+                auto const& a = previous[j * 2];
+                auto const& b = j * 2 + 1 < previous.size() ? previous[j * 2 + 1] : a;
+                level[j] = {std::min(a.first, b.first), std::max(a.second, b.second)};
+            }
+        }
+    }
+}
+
+Range<int> GraphicalArray::updateSummary(size_t from, size_t to)
+{
+    if(m_vector.empty() || m_minimums.empty() || from >= to)
+    {
+        return {};
+    }
+    // The pixel i displays the values from i * ratio to (i + 1) * ratio. The level of
+    // peaks used is the one with the largest blocks that are not larger than a pixel so
+    // the cost depends on the width of the component and not on the size of the array.
+    auto const size  = m_vector.size();
+    auto const width = m_minimums.size();
+    auto const ratio = static_cast<double>(size) / static_cast<double>(width);
+    auto const start = std::min(static_cast<size_t>(static_cast<double>(from) / ratio), width - 1);
+    auto const end   = std::min(static_cast<size_t>(std::ceil(static_cast<double>(to) / ratio)), width);
+    size_t shift = 0;
+    while(shift < m_peaks.size() && static_cast<double>(size_t(2) << shift) <= ratio) { ++shift; }
+    for(size_t i = start; i < end; ++i)
+    {
+        auto const first = std::min(static_cast<size_t>(static_cast<double>(i) * ratio), size - 1);
+        auto const last  = std::min(std::max(static_cast<size_t>(static_cast<double>(i + 1) * ratio), first + 1), size);
+        if(shift == 0)
+        {
+            auto const minmax = std::minmax_element(m_vector.cbegin()+first, m_vector.cbegin()+last);
+            m_minimums[i] = *minmax.first;
+            m_maximums[i] = *minmax.second;
+        }
+        else
+        {
+            auto const& level = m_peaks[shift - 1];
+            auto const bfirst = first >> shift;
+            auto const blast  = ((last - 1) >> shift) + 1;
+            auto minmax = level[bfirst];
+            for(size_t j = bfirst + 1; j < blast; ++j)
+            {
+                minmax.first  = std::min(minmax.first, level[j].first);
+                minmax.second = std::max(minmax.second, level[j].second);
+            }
+            m_minimums[i] = minmax.first;
+            m_maximums[i] = minmax.second;
         }
     }
+    return {static_cast<int>(start), static_cast<int>(std::max(end, start + 1))};
 }
 
 size_t GraphicalArray::getArraySize() const noexcept
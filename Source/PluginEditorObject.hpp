@@ -22,10 +22,11 @@ public:
     GuiPatch(CamomileEditorMouseManager& processor, pd::Patch patch);
     void updateSize();
     void updateObjects();
-    void updateObjectsValues();
+    //! @brief Collects the objects whose value is published by Pd, including the ones of the graphs on parent.
+    void collectObjects(std::vector<PluginEditorObject*>& objects);
 private:
     using object_uptr = std::unique_ptr<PluginEditorObject>;
-    using label_uptr = std::unique_ptr<Component>;
+    using label_uptr = std::unique_ptr<Label>;
     using object_pair = std::pair<object_uptr, label_uptr>;
     
     CamomileEditorMouseManager& m_processor;
@@ -46,9 +47,14 @@ public:
     void mouseDown(const MouseEvent& event) override;
     void mouseDrag(const MouseEvent& event) override;
     void mouseUp(const MouseEvent& event) override;
+    void resized() override;
     size_t getArraySize() const noexcept;
 private:
     void timerCallback() override;
+    //! @brief Updates the minimum and maximum values of the blocks that contain a range of the array.
+    void updatePeaks(size_t from, size_t to);
+    //! @brief Updates the minimum and maximum values of the pixels that display a range of the array.
+    Range<int> updateSummary(size_t from, size_t to);
     template <typename T> T clip(const T& n, const T& lower, const T& upper) {
         return std::max(std::min(n, upper), lower);
     }
@@ -56,9 +62,12 @@ private:
     CamomileAudioProcessor& m_processor;
     pd::Array               m_array;
     std::vector<float>      m_vector;
-    std::vector<float>      m_temp;
+    std::vector<float>      m_minimums;
+    std::vector<float>      m_maximums;
+    std::vector<std::vector<std::pair<float, float>>> m_peaks;
     std::atomic<bool>       m_edited;
     bool                    m_error = false;
+    unsigned int            m_version = 0;
     const std::string string_array = std::string("array");
 };
 
@@ -74,7 +83,10 @@ public:
     
     static PluginEditorObject* createTyped(CamomileEditorMouseManager& p, pd::Gui& g);
     virtual void updateValue();
+    //! @brief Receives the value and the text published by Pd.
+    virtual void receiveValue(float v, char const* text);
     virtual void updateInterface();
+    virtual void collectObjects(std::vector<PluginEditorObject*>& objects);
     std::unique_ptr<Label> getLabel();
     pd::Gui getGUI();
 protected:
@@ -86,6 +98,11 @@ protected:
     void startEdition() noexcept;
     void stopEdition() noexcept;
     
+    //! @brief Sets if the paint method fills the bounds with the background color.
+    //! @details The object is then opaque when its background color is opaque, so the
+    //! objects behind it are not repainted each time its value changes.
+    void setFillsBackground(bool state);
+    
     pd::Gui     gui;
     CamomileEditorMouseManager&   patch;
     std::atomic<bool> edited;
@@ -94,13 +111,18 @@ protected:
     float       max     = 1;
 
 private:
+    bool            fills_background = false;
+    unsigned int    background = 0;
+    unsigned int    foreground = 0;
+    float           font_height = 0.f;
+    bool            log_scale = false;
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PluginEditorObject)
 };
 
 class GuiBang : public PluginEditorObject
 {
 public:
-    GuiBang(CamomileEditorMouseManager& p, pd::Gui& g) : PluginEditorObject(p, g) {}
+    GuiBang(CamomileEditorMouseManager& p, pd::Gui& g) : PluginEditorObject(p, g) { setFillsBackground(true); }
     void paint(Graphics& g) override;
     void mouseDown(const MouseEvent& e) override;
     void mouseUp(const MouseEvent& e) override;
@@ -109,7 +131,7 @@ public:
 class GuiToggle : public PluginEditorObject
 {
 public:
-    GuiToggle(CamomileEditorMouseManager& p, pd::Gui& g) : PluginEditorObject(p, g) {}
+    GuiToggle(CamomileEditorMouseManager& p, pd::Gui& g) : PluginEditorObject(p, g) { setFillsBackground(true); }
     void paint(Graphics& g) override;
     void mouseDown(const MouseEvent& e) override;
 };
@@ -117,7 +139,7 @@ public:
 class GuiSliderHorizontal : public PluginEditorObject
 {
 public:
-    GuiSliderHorizontal(CamomileEditorMouseManager& p, pd::Gui& g) : PluginEditorObject(p, g) {}
+    GuiSliderHorizontal(CamomileEditorMouseManager& p, pd::Gui& g) : PluginEditorObject(p, g) { setFillsBackground(true); }
     void paint(Graphics& g) override;
     void mouseDown(const MouseEvent& e) override;
     void mouseDrag(const MouseEvent& e) override;
@@ -130,7 +152,7 @@ private:
 class GuiSliderVertical : public PluginEditorObject
 {
 public:
-    GuiSliderVertical(CamomileEditorMouseManager& p, pd::Gui& g) : PluginEditorObject(p, g) {}
+    GuiSliderVertical(CamomileEditorMouseManager& p, pd::Gui& g) : PluginEditorObject(p, g) { setFillsBackground(true); }
     void paint(Graphics& g) override;
     void mouseDown(const MouseEvent& e) override;
     void mouseDrag(const MouseEvent& e) override;
@@ -143,7 +165,7 @@ private:
 class GuiRadioHorizontal : public PluginEditorObject
 {
 public:
-    GuiRadioHorizontal(CamomileEditorMouseManager& p, pd::Gui& g) : PluginEditorObject(p, g) {}
+    GuiRadioHorizontal(CamomileEditorMouseManager& p, pd::Gui& g) : PluginEditorObject(p, g) { setFillsBackground(true); }
     void paint(Graphics& g) override;
     void mouseDown(const MouseEvent& e) override;
 };
@@ -151,7 +173,7 @@ public:
 class GuiRadioVertical : public PluginEditorObject
 {
 public:
-    GuiRadioVertical(CamomileEditorMouseManager& p, pd::Gui& g) : PluginEditorObject(p, g) {}
+    GuiRadioVertical(CamomileEditorMouseManager& p, pd::Gui& g) : PluginEditorObject(p, g) { setFillsBackground(true); }
     void paint(Graphics& g) override;
     void mouseDown(const MouseEvent& e) override;
 };
@@ -170,6 +192,9 @@ class GuiComment : public PluginEditorObject
 public:
     GuiComment(CamomileEditorMouseManager& p, pd::Gui& g);
     void paint(Graphics& g) override;
+    void updateInterface() override;
+private:
+    std::string m_text;
 };
 
 class GuiTextEditor : public PluginEditorObject
@@ -177,6 +202,7 @@ class GuiTextEditor : public PluginEditorObject
 public:
     GuiTextEditor(CamomileEditorMouseManager& p, pd::Gui& g);
     void updateValue() override;
+    void receiveValue(float v, char const* text) override;
     void mouseDoubleClick(const juce::MouseEvent&) override;
 protected:
     juce::Label label;
@@ -217,6 +243,9 @@ public:
     GuiAtomSymbol(CamomileEditorMouseManager& p, pd::Gui& g);
     void paint(juce::Graphics& g) override;
     void updateValue() override;
+    void receiveValue(float v, char const* text) override;
+private:
+    juce::String published;
 };
 
 class GuiAtomList : public GuiTextEditor
@@ -225,6 +254,9 @@ public:
     GuiAtomList(CamomileEditorMouseManager& p, pd::Gui& g);
     void paint(juce::Graphics& g) override;
     void updateValue() override;
+    void receiveValue(float v, char const* text) override;
+private:
+    juce::String published;
 };
 
 class GuiArray : public PluginEditorObject
@@ -239,15 +271,17 @@ private:
     GraphicalArray m_array;
 };
 
-class GuiGraphOnParent : public PluginEditorObject
+class GuiGraphOnParent : public PluginEditorObject, private AsyncUpdater
 {
 public:
     GuiGraphOnParent(CamomileEditorMouseManager& p, pd::Gui& g);
     void paint(Graphics& ) override;
-    void updateValue() override;
     void updateInterface() override;
+    void collectObjects(std::vector<PluginEditorObject*>& objects) override;
 private:
-    GuiPatch m_patch;
+    //! @brief Creates the content the first time the graph is painted.
+    void handleAsyncUpdate() override;
+    std::unique_ptr<GuiPatch> m_patch;
 };
 
 
@@ -92,6 +92,12 @@ bool CamomileEnvironment::wantsAutoProgram() { return get().m_auto_program; }
 
 bool CamomileEnvironment::wantsAutoBypass() { return get().m_auto_bypass; }
 
+bool CamomileEnvironment::wantsParamBatch() { return get().m_param_batch; }
+
+int CamomileEnvironment::getBlockSize() { return get().block_size; }
+
+int CamomileEnvironment::getOversampling() { return get().oversampling; }
+
 //////////////////////////////////////////////////////////////////////////////////////////////
 //                                          PROGRAMS                                        //
 //////////////////////////////////////////////////////////////////////////////////////////////
@@ -293,7 +299,10 @@ CamomileEnvironment::CamomileEnvironment()
                         {
                             if(state.test(init_play_head))
                                 throw std::string("already defined");
-                            play_head_level = static_cast<int>(CamomileParser::getBool(entry.second));
+                            if(CamomileParser::getString(entry.second) == "changes")
+                                play_head_level = 2;
+                            else
+                                play_head_level = static_cast<int>(CamomileParser::getBool(entry.second));
                             state.set(init_play_head);
                         }
                         else if(entry.first == "midionly")
@@ -380,6 +389,33 @@ CamomileEnvironment::CamomileEnvironment()
                             m_auto_bypass = CamomileParser::getBool(entry.second);
                             state.set(init_auto_bypass);
                         }
+                        else if(entry.first == "parambatch")
+                        {
+                            if(state.test(init_param_batch))
+                                throw std::string("already defined");
+                            m_param_batch = CamomileParser::getBool(entry.second);
+                            state.set(init_param_batch);
+                        }
+                        else if(entry.first == "blocksize")
+                        {
+                            if(state.test(init_block_size))
+                                throw std::string("already defined");
+                            const int value = CamomileParser::getInteger(entry.second);
+                            if(value < 64 || value > 2048 || (value & (value - 1)))
+                                throw std::string("must be a power of two between 64 and 2048");
+                            block_size = value;
+                            state.set(init_block_size);
+                        }
+                        else if(entry.first == "oversampling")
+                        {
+                            if(state.test(init_oversampling))
+                                throw std::string("already defined");
+                            const int value = CamomileParser::getInteger(entry.second);
+                            if(value != 1 && value != 2 && value != 4 && value != 8)
+                                throw std::string("must be 1, 2, 4 or 8");
+                            oversampling = value;
+                            state.set(init_oversampling);
+                        }
                         else if(entry.first == "type")
                         {
                             if(state.test(init_type))
@@ -91,6 +91,7 @@ public:
     static bool producesMidi();
     
     //! @brief Gets if the patch wants play head information.
+    //! @details 0 for none, 1 for all the information at each tick, 2 for the changes only.
     static int getPlayHeadLevel();
     
     //! @brief Gets if the patch is valid (no audio).
@@ -114,6 +115,15 @@ public:
     //! @brief Gets if the plugin wants to auto bypass the process.
     static bool wantsAutoBypass();
     
+    //! @brief Gets if the plugin wants to receive the changed parameters in one message.
+    static bool wantsParamBatch();
+    
+    //! @brief Gets the number of samples processed by Pd between two exchanges with the host.
+    static int getBlockSize();
+    
+    //! @brief Gets the oversampling factor of the Pd sample rate.
+    static int getOversampling();
+    
     //////////////////////////////////////////////////////////////////////////////////////////
     //                                      PROGRAMS                                        //
     //////////////////////////////////////////////////////////////////////////////////////////
@@ -162,7 +172,10 @@ private:
         init_auto_program = 13,
         init_auto_bypass  = 14,
         init_manufacturer = 15,
-        all = 16
+        init_block_size   = 16,
+        init_oversampling = 17,
+        init_param_batch  = 18,
+        all = 19
     };
     
     std::string     plugin_name = "Camomile";
@@ -187,6 +200,9 @@ private:
     bool    m_auto_reload     = false;
     bool    m_auto_program    = true;
     bool    m_auto_bypass     = true;
+    bool    m_param_batch     = false;
+    int     block_size        = 64;
+    int     oversampling      = 1;
 
     uint32_t default_foreground_color = 0;
     uint32_t default_background_color = 0xFFFFFFFF;
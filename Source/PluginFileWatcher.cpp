@@ -7,8 +7,261 @@
 #include "PluginFileWatcher.h"
 #include <iostream>
 
+#if JUCE_LINUX
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
 
+// ======================================================================================== //
+//                                  FILE WATCHER SERVICE                                    //
+// ======================================================================================== //
 
+CamomileFileWatcherService::CamomileFileWatcherService()
+{
+#if JUCE_LINUX
+    m_inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#endif
+}
 
+CamomileFileWatcherService::~CamomileFileWatcherService()
+{
+    stopTimer();
+#if JUCE_LINUX
+    if(m_inotify >= 0)
+    {
+        close(m_inotify);
+    }
+#endif
+}
 
+void CamomileFileWatcherService::addWatcher(CamomileFileWatcher& watcher)
+{
+    m_watchers.insert(&watcher);
+    if(!isTimerRunning())
+    {
+        startTimer(timer_interval);
+    }
+}
 
+void CamomileFileWatcherService::removeWatcher(CamomileFileWatcher& watcher)
+{
+    unwatch(watcher);
+    m_watchers.erase(&watcher);
+    if(m_watchers.empty())
+    {
+        stopTimer();
+    }
+}
+
+void CamomileFileWatcherService::watch(CamomileFileWatcher& watcher, File const& file)
+{
+    if(!file.existsAsFile())
+    {
+        return;
+    }
+    auto& current = m_files[file.getFullPathName()];
+    if(current.watchers.empty())
+    {
+        current.time = file.getLastModificationTime();
+        watchDirectory(file.getParentDirectory());
+    }
+    current.watchers.insert(&watcher);
+}
+
+void CamomileFileWatcherService::unwatch(CamomileFileWatcher& watcher)
+{
+    bool removed = false;
+    for(auto it = m_files.begin(); it != m_files.end();)
+    {
+        it->second.watchers.erase(&watcher);
+        if(it->second.watchers.empty())
+        {
+            it = m_files.erase(it);
+            removed = true;
+        }
+        else
+        {
+            ++it;
+        }
+    }
+    if(removed)
+    {
+        unwatchDirectories();
+    }
+}
+
+void CamomileFileWatcherService::watchDirectory(File const& directory)
+{
+#if JUCE_LINUX
+    String const path = directory.getFullPathName();
+    if(m_inotify >= 0 && m_directories.find(path) == m_directories.end())
+    {
+        // The directory is watched so the files replaced by a rename are detected.
+        const int wd = inotify_add_watch(m_inotify, path.toRawUTF8(), IN_CLOSE_WRITE | IN_MOVED_TO);
+        if(wd >= 0)
+        {
+            m_directories[path] = wd;
+        }
+    }
+#else
+    ignoreUnused(directory);
+#endif
+}
+
+void CamomileFileWatcherService::unwatchDirectories()
+{
+#if JUCE_LINUX
+    for(auto it = m_directories.begin(); it != m_directories.end();)
+    {
+        auto const used = std::any_of(m_files.begin(), m_files.end(), [&it](auto const& file) {
+            return File(file.first).getParentDirectory().getFullPathName() == it->first; });
+        if(!used)
+        {
+            inotify_rm_watch(m_inotify, it->second);
+            it = m_directories.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+#endif
+}
+
+void CamomileFileWatcherService::changed(String const& path)
+{
+    auto it = m_files.find(path);
+    if(it != m_files.end())
+    {
+        it->second.changed = Time::getMillisecondCounterHiRes();
+    }
+}
+
+void CamomileFileWatcherService::readEvents()
+{
+#if JUCE_LINUX
+    alignas(struct inotify_event) char buffer[4096];
+    ssize_t length;
+    while((length = read(m_inotify, buffer, sizeof(buffer))) > 0)
+    {
+        for(char const* ptr = buffer; ptr < buffer + length;)
+        {
+            auto const* event = reinterpret_cast<struct inotify_event const*>(ptr);
+            if(event->mask & IN_Q_OVERFLOW)
+            {
+                for(auto& file : m_files)
+                {
+                    file.second.changed = Time::getMillisecondCounterHiRes();
+                }
+            }
+            else if(event->len)
+            {
+                auto const directory = std::find_if(m_directories.begin(), m_directories.end(), [event](auto const& dir) {
+                    return dir.second == event->wd; });
+                if(directory != m_directories.end())
+                {
+                    changed(File(directory->first).getChildFile(String(CharPointer_UTF8(event->name))).getFullPathName());
+                }
+            }
+            ptr += sizeof(struct inotify_event) + event->len;
+        }
+    }
+#endif
+}
+
+void CamomileFileWatcherService::pollFiles()
+{
+    // The files that are not watched by inotify are polled at a lower rate.
+    if(++m_polls < poll_interval)
+    {
+        return;
+    }
+    m_polls = 0;
+    for(auto& file : m_files)
+    {
+        File const current(file.first);
+        if(m_directories.count(current.getParentDirectory().getFullPathName()))
+        {
+            continue;
+        }
+        if(current.existsAsFile())
+        {
+            Time const time = current.getLastModificationTime();
+            if(time != file.second.time)
+            {
+                file.second.time = time;
+                file.second.changed = Time::getMillisecondCounterHiRes();
+            }
+        }
+    }
+}
+
+void CamomileFileWatcherService::timerCallback()
+{
+    for(auto* watcher : m_watchers)
+    {
+        watcher->collectFiles();
+    }
+    readEvents();
+    pollFiles();
+
+    // A watcher is notified once when the writes of its files are over.
+    std::set<CamomileFileWatcher*> notified;
+    double const now = Time::getMillisecondCounterHiRes();
+    for(auto& file : m_files)
+    {
+        if(file.second.changed > 0. && now - file.second.changed >= debounce)
+        {
+            file.second.changed = 0.;
+            file.second.time = File(file.first).getLastModificationTime();
+            notified.insert(file.second.watchers.begin(), file.second.watchers.end());
+        }
+    }
+    for(auto* watcher : notified)
+    {
+        if(m_watchers.count(watcher))
+        {
+            watcher->fileChanged();
+        }
+    }
+}
+
+// ======================================================================================== //
+//                                      FILE WATCHER                                        //
+// ======================================================================================== //
+
+CamomileFileWatcher::CamomileFileWatcher() :
+m_file(CamomileEnvironment::getPatchPath() + File::getSeparatorString() + CamomileEnvironment::getPatchName()),
+m_enabled(CamomileEnvironment::wantsAutoReload())
+{
+    if(m_enabled)
+    {
+        m_service->addWatcher(*this);
+        m_service->watch(*this, m_file);
+    }
+}
+
+CamomileFileWatcher::~CamomileFileWatcher()
+{
+    if(m_enabled)
+    {
+        m_service->removeWatcher(*this);
+    }
+}
+
+void CamomileFileWatcher::watchFile(std::string const& path)
+{
+    if(m_enabled)
+    {
+        m_service->watch(*this, File::getCurrentWorkingDirectory().getChildFile(String(path)));
+    }
+}
+
+void CamomileFileWatcher::unwatchFiles()
+{
+    if(m_enabled)
+    {
+        m_service->unwatch(*this);
+        m_service->watch(*this, m_file);
+    }
+}
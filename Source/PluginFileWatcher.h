@@ -8,46 +8,84 @@
 
 #include <JuceHeader.h>
 #include "PluginConfig.h"
+#include <map>
+#include <set>
+
+class CamomileFileWatcher;
 
 // ======================================================================================== //
-//                                      FILE WATCHER                                        //
+//                                  FILE WATCHER SERVICE                                    //
 // ======================================================================================== //
 
-class CamomileFileWatcher : public Timer
+//! @brief The service that watches the files of all the plugins of the process.
+//! @details A file is watched once whatever the number of plugins that depend on it. On Linux,
+//! the changes are notified by inotify on the directories of the files, so the files replaced
+//! by the editors are also detected, elsewhere the modification times are polled. The changes
+//! are debounced so a burst of writes only triggers one notification.
+class CamomileFileWatcherService : private Timer
 {
 public:
-    CamomileFileWatcher() :
-    m_file(CamomileEnvironment::getPatchPath() + File::getSeparatorString() + CamomileEnvironment::getPatchName())
-    {
-        if(CamomileEnvironment::wantsAutoReload())
-        {
-            if(m_file.exists())
-            {
-                m_time = m_file.getLastModificationTime();
-                startTimer(100);
-            }
-        }
-    }
-    
-    virtual ~CamomileFileWatcher() {}
-    
-    void timerCallback()
+    CamomileFileWatcherService();
+    ~CamomileFileWatcherService();
+
+    void addWatcher(CamomileFileWatcher& watcher);
+    void removeWatcher(CamomileFileWatcher& watcher);
+
+    void watch(CamomileFileWatcher& watcher, File const& file);
+    void unwatch(CamomileFileWatcher& watcher);
+
+private:
+    void timerCallback() override;
+    void readEvents();
+    void pollFiles();
+    void changed(String const& path);
+    void watchDirectory(File const& directory);
+    void unwatchDirectories();
+
+    struct entry
     {
-        if(m_file.exists())
-        {
-            Time const ntime = m_file.getLastModificationTime();
-            if(ntime != m_time)
-            {
-                m_time = ntime;
-                fileChanged();
-            }
-        }
-    }
-    
+        Time    time;
+        double  changed = 0.;
+        std::set<CamomileFileWatcher*> watchers;
+    };
+
+    static constexpr int    timer_interval  = 100;
+    static constexpr int    poll_interval   = 5;
+    static constexpr double debounce        = 250.;
+
+    std::set<CamomileFileWatcher*>  m_watchers;
+    std::map<String, entry>         m_files;
+    std::map<String, int>           m_directories;
+    int                             m_inotify = -1;
+    int                             m_polls   = 0;
+};
+
+// ======================================================================================== //
+//                                      FILE WATCHER                                        //
+// ======================================================================================== //
+
+//! @brief The files of a plugin that trigger the reload of the patch.
+//! @details The patch file is watched if the plugin wants to auto reload the patch and
+//! the other dependencies are added when the patch opens them.
+class CamomileFileWatcher
+{
+public:
+    CamomileFileWatcher();
+    virtual ~CamomileFileWatcher();
+
+    //! @brief Adds a file to the dependencies.
+    void watchFile(std::string const& path);
+
+    //! @brief Removes the dependencies but the patch file.
+    void unwatchFiles();
+
+    //! @brief Called by the service before checking the files, to add the new dependencies.
+    virtual void collectFiles() {}
+
     virtual void fileChanged() = 0;
-    
+
 private:
+    SharedResourcePointer<CamomileFileWatcherService> m_service;
     File const m_file;
-    Time m_time;
+    bool const m_enabled;
 };
-
@@ -53,6 +53,7 @@ float CamomileAudioParameter::getValue() const
 void CamomileAudioParameter::setValue(float newValue)
 {
     m_value = convertFrom0to1(newValue);
+    m_generation.fetch_add(1, std::memory_order_release);
 }
 
 float CamomileAudioParameter::getDefaultValue() const
@@ -212,18 +213,6 @@ CamomileAudioParameter* CamomileAudioParameter::parse(const std::string& definit
     }
 }
 
-void CamomileAudioParameter::saveStateInformation(XmlElement& xml, Array<AudioProcessorParameter*> const& parameters)
-{
-    XmlElement* params = xml.createNewChildElement("params");
-    if(params)
-    {
-        for(int i = 0; i < parameters.size(); ++i)
-        {
-            params->setAttribute(String("param") + String(i+1), static_cast<double>(parameters[i]->getValue()));
-        }
-    }
-}
-
 void CamomileAudioParameter::loadStateInformation(XmlElement const& xml, Array<AudioProcessorParameter*> const& parameters)
 {
     XmlElement const* params = xml.getChildByName(juce::StringRef("params"));
@@ -39,11 +39,15 @@ public:
     bool isAutomatable() const override;
     bool isMetaParameter() const override;
     
+    //! @brief Gets the number of times the value has been set.
+    //! @details The counter can be compared with a previous one to know if the value changed.
+    uint32 getGeneration() const noexcept { return m_generation.load(std::memory_order_acquire); }
+    
     static CamomileAudioParameter* parse(const std::string& definition);
-    static void saveStateInformation(XmlElement& xml, Array<AudioProcessorParameter*> const& parameters);
     static void loadStateInformation(XmlElement const& xml, Array<AudioProcessorParameter*> const& parameters);
 private:
     std::atomic<float> m_value;
+    std::atomic<uint32> m_generation {0};
     NormalisableRange<float> const m_norm_range;
     
     float const m_default;
@@ -24,6 +24,7 @@ m_accepts_midi(CamomileEnvironment::wantsMidi()),
 m_produces_midi(CamomileEnvironment::producesMidi()),
 m_is_midi_effect(CamomileEnvironment::isMidiOnly()),
 m_auto_bypass(CamomileEnvironment::wantsAutoBypass()),
+m_params_batch(CamomileEnvironment::wantsParamBatch()),
 m_tail_length(static_cast<double>(CamomileEnvironment::getTailLengthSeconds())),
 m_programs(CamomileEnvironment::getPrograms())
 {
@@ -38,15 +39,26 @@ m_programs(CamomileEnvironment::getPrograms())
     if(CamomileEnvironment::isValid())
     {
         m_atoms_param.resize(2);
-        m_atoms_playhead.reserve(3);
         m_atoms_playhead.resize(1);
+        m_atoms_playhead2.resize(2);
+        m_atoms_playhead3.resize(3);
         
         m_midi_buffer_in.ensureSize(2048);
         m_midi_buffer_out.ensureSize(2048);
         m_midi_buffer_temp.ensureSize(2048);
+        m_midibyte_buffer.resize(4096);
+        m_sysex_buffer.reserve(4096);
+        m_midi_messages.reserve(2048);
+        m_midi_sizes.reserve(2048);
+        m_state.atoms.reserve(state_atoms);
+        m_state.text.reserve(state_text);
+        m_state.sizes.reserve(state_lists);
         
-        prepareDSP(getTotalNumInputChannels(), getTotalNumOutputChannels(), getSampleRate());
-        setLatencySamples(CamomileEnvironment::getLatencySamples() + Instance::getBlockSize());
+        prepareDSP(getTotalNumInputChannels(), getTotalNumOutputChannels(),
+                   getSampleRate() * CamomileEnvironment::getOversampling(), CamomileEnvironment::getBlockSize());
+        m_audio_blocksize = Instance::getBlockSize() / CamomileEnvironment::getOversampling();
+        m_audio_latency = CamomileEnvironment::getLatencySamples();
+        updateLatency();
         
         auto const& params = CamomileEnvironment::getParams();
         for(size_t i = 0; i < params.size(); ++i)
@@ -71,9 +83,13 @@ m_programs(CamomileEnvironment::getPrograms())
         }
         m_params_states.resize(getParameters().size());
         std::fill(m_params_states.begin(), m_params_states.end(), false);
+        m_params_generations.resize(getParameters().size());
+        prepareParameters(getParameters().size());
+        m_atoms_params.reserve(256);
         openPatch(CamomileEnvironment::getPatchPath(), CamomileEnvironment::getPatchName());
         processMessages();
     }
+    startTimer(console_interval);
 }
 
 
@@ -111,6 +127,15 @@ void CamomileAudioProcessor::changeProgramName(int index, const String& newName)
     }
 }
 
+void CamomileAudioProcessor::collectFiles()
+{
+    std::string path;
+    while(dequeueFile(path))
+    {
+        watchFile(path);
+    }
+}
+
 void CamomileAudioProcessor::fileChanged()
 {
     reloadPatch();
@@ -118,51 +143,133 @@ void CamomileAudioProcessor::fileChanged()
 
 void CamomileAudioProcessor::reloadPatch()
 {
-    MemoryBlock xml;
-    suspendProcessing(true);
-    releaseResources();
-    sendMessagesFromQueue();
+    // The new patch is loaded in another instance of Pd while the current one keeps
+    // processing and receives the bus layout and the saved state from this thread,
+    // then the audio thread swaps the instances between two ticks and crossfades
+    // the outputs of the instances.
+    captureLists(m_reload_lists);
+    unwatchFiles();
+    loadPatch(CamomileEnvironment::getPatchPath(), CamomileEnvironment::getPatchName());
+    sendCurrentBusesLayoutInformation(true);
+    loadInformation(m_reload_lists, true);
+    if(!swapPatchAsync())
     {
-        const MessageManagerLock mmLock;
-        getStateInformation(xml);
+        suspendProcessing(true);
+        swapPatchInternal(false);
+        processMessages();
+        suspendProcessing(false);
     }
-    openPatch(CamomileEnvironment::getPatchPath(), CamomileEnvironment::getPatchName());
+    else if(!m_reload_faded.wait(state_timeout) && m_reload_fading.exchange(false))
     {
-        const MessageManagerLock mmLock;
-        setStateInformation(xml.getData(), static_cast<int>(xml.getSize()));
+        // The audio thread stopped before the end of the crossfade.
+        const ScopedLock lock(getCallbackLock());
+        stopFading();
     }
-    prepareToPlay(getSampleRate(), AudioProcessor::getBlockSize());
+    releasePatch();
+    m_reload_lists.clear();
     if(CamomileEditor* editor = dynamic_cast<CamomileEditor*>(getActiveEditor()))
     {
         const MessageManagerLock mmLock;
         editor->reloadPatch();
     }
     add(ConsoleLevel::Normal, "camomile: the patch \"" + CamomileEnvironment::getPatchName() + "\" has been reloaded");
-    suspendProcessing(false);
+}
+
+bool CamomileAudioProcessor::swapPatchAsync()
+{
+    if(isNonRealtime() || isSuspended() || isSendingStalled())
+    {
+        return false;
+    }
+    m_reload_swapped.reset();
+    m_reload_faded.reset();
+    m_reload_requested.store(true);
+    if(!m_reload_swapped.wait(state_timeout))
+    {
+        if(m_reload_requested.exchange(false))
+        {
+            return false;
+        }
+        m_reload_swapped.wait(-1);
+    }
+    return true;
+}
+
+void CamomileAudioProcessor::swapPatchRequested(const bool crossfade)
+{
+    if(m_reload_requested.load() && m_reload_requested.exchange(false))
+    {
+        // The pending messages are sent to and received from the previous patch.
+        sendMessagesFromQueue();
+        processMessages();
+        swapPatchInternal(crossfade);
+        m_reload_fading.store(true);
+        m_reload_swapped.signal();
+    }
+}
+
+void CamomileAudioProcessor::fadePatchRequested()
+{
+    if(m_reload_fading.load() && !isFading() && m_reload_fading.exchange(false))
+    {
+        m_reload_faded.signal();
+    }
+}
+
+void CamomileAudioProcessor::swapPatchInternal(const bool crossfade)
+{
+    // Only the instances are swapped here, the new patch already received
+    // its information from the message thread.
+    const double samplerate = getSampleRate() * CamomileEnvironment::getOversampling();
+    swapPatch(crossfade ? static_cast<int>(samplerate * reload_fade / 1000.0) : 0);
+    m_params_sync = true;
+    m_playhead_sync = true;
+    m_midibyte_index = 0;
+    m_midibyte_issysex = false;
 }
 
 //==============================================================================
 
 void CamomileAudioProcessor::prepareToPlay(double sampleRate, int samplesPerBlock)
 {
-    prepareDSP(getTotalNumInputChannels(), getTotalNumOutputChannels(), sampleRate);
+    const int oversampling = CamomileEnvironment::getOversampling();
+    prepareDSP(getTotalNumInputChannels(), getTotalNumOutputChannels(), sampleRate * oversampling, CamomileEnvironment::getBlockSize());
     sendCurrentBusesLayoutInformation();
     m_audio_advancement = 0;
-    const size_t blksize = static_cast<size_t>(Instance::getBlockSize());
+    m_params_sync = true;
+    m_playhead_sync = true;
+    m_playhead_valid = false;
+    m_params_ramp = sampleRate > 0. ? static_cast<float>(std::max(samplesPerBlock, 0) * 1000.0 / sampleRate) : 0.f;
+    m_audio_blocksize = Instance::getBlockSize() / oversampling;
+    const size_t blksize = static_cast<size_t>(m_audio_blocksize);
     const size_t nins = std::max(static_cast<size_t>(getTotalNumInputChannels()), static_cast<size_t>(2));
     const size_t nouts = std::max(static_cast<size_t>(getTotalNumOutputChannels()), static_cast<size_t>(2));
     m_audio_buffer_in.resize(nins * blksize);
     m_audio_buffer_out.resize(nouts * blksize);
     std::fill(m_audio_buffer_out.begin(), m_audio_buffer_out.end(), 0.f);
     std::fill(m_audio_buffer_in.begin(), m_audio_buffer_in.end(), 0.f);
+    m_audio_channels_in.resize(static_cast<size_t>(getTotalNumInputChannels()));
+    m_audio_channels_out.resize(static_cast<size_t>(getTotalNumOutputChannels()));
+    m_oversampler.reset();
+    if(oversampling > 1)
+    {
+        const size_t nchannels = std::max(std::max(m_audio_channels_in.size(), m_audio_channels_out.size()), static_cast<size_t>(1));
+        const size_t factor = static_cast<size_t>(std::log2(oversampling));
+        m_oversampler = std::make_unique<dsp::Oversampling<float>>(nchannels, factor, dsp::Oversampling<float>::filterHalfBandPolyphaseIIR, true, true);
+        m_oversampler->initProcessing(blksize);
+        m_oversampled_in.resize(m_audio_channels_in.size());
+        m_oversampled_out.resize(m_audio_channels_out.size());
+    }
+    // When the host block size is a multiple of the processing block size, the
+    // channels are processed in place and no extra latency is needed.
+    m_audio_direct = samplesPerBlock > 0 && (samplesPerBlock % static_cast<int>(blksize)) == 0;
+    updateLatency();
     m_midi_buffer_in.clear();
     m_midi_buffer_out.clear();
     m_midi_buffer_temp.clear();
     
     m_midibyte_index = 0;
-    m_midibyte_buffer[0] = 0;
-    m_midibyte_buffer[1] = 0;
-    m_midibyte_buffer[2] = 0;
+    m_midibyte_issysex = false;
     startDSP();
     processMessages();
     processPrints();
@@ -179,55 +286,168 @@ void CamomileAudioProcessor::releaseResources()
     m_audio_advancement = 0;
 }
 
+int CamomileAudioProcessor::computeLatency() const
+{
+    const int oversampling = m_oversampler ? static_cast<int>(std::round(m_oversampler->getLatencyInSamples())) : 0;
+    return m_audio_latency + oversampling + (m_audio_direct ? 0 : m_audio_blocksize);
+}
+
+void CamomileAudioProcessor::updateLatency()
+{
+    cancelPendingUpdate();
+    setLatencySamples(computeLatency());
+}
+
+void CamomileAudioProcessor::updateLatencyAsync()
+{
+    // The host listeners are notified synchronously, so they must not be called by the audio thread.
+    m_audio_latency_async.store(computeLatency());
+    triggerAsyncUpdate();
+}
+
+void CamomileAudioProcessor::handleAsyncUpdate()
+{
+    setLatencySamples(m_audio_latency_async.load());
+}
+
+void CamomileAudioProcessor::timerCallback()
+{
+    processPrints();
+    synchronize();
+}
+
 void CamomileAudioProcessor::sendParameters()
 {
+    // Only the parameters that changed since the last call are sent,
+    // all of them after the preparation of the DSP.
     auto const& parameters = AudioProcessor::getParameters();
+    const bool sync = m_params_sync;
+    m_params_sync = false;
+    m_atoms_params.clear();
     for(int i = 0; i < parameters.size(); ++i)
     {
         auto const* param = static_cast<CamomileAudioParameter const*>(parameters.getUnchecked(i));
-        m_atoms_param[0] = static_cast<float>(i+1);
-        m_atoms_param[1] = param->convertFrom0to1(param->getValue());
-        sendList("param", m_atoms_param);
+        const uint32 generation = param->getGeneration();
+        if(!sync && generation == m_params_generations[i])
+        {
+            continue;
+        }
+        m_params_generations[i] = generation;
+        const float value = param->convertFrom0to1(param->getValue());
+        // The param~ objects reach the new value at the end of the host block.
+        sendParameterRamp(i, value, sync ? 0.f : m_params_ramp);
+        if(m_params_batch)
+        {
+            m_atoms_params.push_back(static_cast<float>(i+1));
+            m_atoms_params.push_back(value);
+            if(m_atoms_params.size() >= 256)
+            {
+                sendMessage("param", "batch", m_atoms_params);
+                m_atoms_params.clear();
+            }
+        }
+        else
+        {
+            m_atoms_param[0] = static_cast<float>(i+1);
+            m_atoms_param[1] = value;
+            sendList("param", m_atoms_param);
+        }
+    }
+    if(!m_atoms_params.empty())
+    {
+        sendMessage("param", "batch", m_atoms_params);
     }
 }
 
+void CamomileAudioProcessor::updatePlayhead()
+{
+    // The host position is only valid at the beginning of the block.
+    if(CamomileEnvironment::getPlayHeadLevel() > 0)
+    {
+        AudioPlayHead* playhead = getPlayHead();
+        m_playhead_valid = playhead && playhead->getCurrentPosition(m_playhead_infos);
+    }
+    m_playhead_offset = 0;
+}
+
 void CamomileAudioProcessor::sendPlayhead()
 {
     int const phl = CamomileEnvironment::getPlayHeadLevel();
-    if(phl > 0)
+    if(phl > 0 && m_playhead_valid)
     {
-        AudioPlayHead* playhead = getPlayHead();
-        AudioPlayHead::CurrentPositionInfo infos;
-        if(playhead && playhead->getCurrentPosition(infos))
+        AudioPlayHead::CurrentPositionInfo const& infos = m_playhead_infos;
+        AudioPlayHead::CurrentPositionInfo& last = m_playhead_last;
+        const bool all = phl == 1 || m_playhead_sync;
+        m_playhead_sync = false;
+        
+        // The position is extrapolated to the beginning of the tick.
+        double ppq = infos.ppqPosition;
+        int64 samples = infos.timeInSamples;
+        double seconds = infos.timeInSeconds;
+        if(infos.isPlaying && m_playhead_offset != 0 && getSampleRate() > 0.)
+        {
+            const double offset = static_cast<double>(m_playhead_offset) / getSampleRate();
+            ppq     += offset * infos.bpm / 60.;
+            samples += m_playhead_offset;
+            seconds += offset;
+        }
+        
+        if(all || infos.isPlaying != last.isPlaying)
         {
             m_atoms_playhead[0] = static_cast<float>(infos.isPlaying);
             sendMessage("playhead", "playing", m_atoms_playhead);
+        }
+        if(all || infos.isRecording != last.isRecording)
+        {
             m_atoms_playhead[0] = static_cast<float>(infos.isRecording);
             sendMessage("playhead", "recording", m_atoms_playhead);
-            m_atoms_playhead[0] = static_cast<float>(infos.isLooping);
-            m_atoms_playhead.push_back(static_cast<float>(infos.ppqLoopStart));
-            m_atoms_playhead.push_back(static_cast<float>(infos.ppqLoopEnd));
-            sendMessage("playhead", "looping", m_atoms_playhead);
-            m_atoms_playhead.resize(1);
+        }
+        if(all || infos.isLooping != last.isLooping ||
+           infos.ppqLoopStart != last.ppqLoopStart || infos.ppqLoopEnd != last.ppqLoopEnd)
+        {
+            m_atoms_playhead3[0] = static_cast<float>(infos.isLooping);
+            m_atoms_playhead3[1] = static_cast<float>(infos.ppqLoopStart);
+            m_atoms_playhead3[2] = static_cast<float>(infos.ppqLoopEnd);
+            sendMessage("playhead", "looping", m_atoms_playhead3);
+        }
+        if(all || infos.editOriginTime != last.editOriginTime)
+        {
             m_atoms_playhead[0] = static_cast<float>(infos.editOriginTime);
             sendMessage("playhead", "edittime", m_atoms_playhead);
+        }
+        if(all || infos.frameRate != last.frameRate)
+        {
             m_atoms_playhead[0] = static_cast<float>(infos.frameRate);
             sendMessage("playhead", "framerate", m_atoms_playhead);
-            
+        }
+        if(all || infos.bpm != last.bpm)
+        {
             m_atoms_playhead[0] = static_cast<float>(infos.bpm);
             sendMessage("playhead", "bpm", m_atoms_playhead);
+        }
+        if(all || infos.ppqPositionOfLastBarStart != last.ppqPositionOfLastBarStart)
+        {
             m_atoms_playhead[0] = static_cast<float>(infos.ppqPositionOfLastBarStart);
             sendMessage("playhead", "lastbar", m_atoms_playhead);
-            m_atoms_playhead[0] = static_cast<float>(infos.timeSigNumerator);
-            m_atoms_playhead.push_back(static_cast<float>(infos.timeSigDenominator));
-            sendMessage("playhead", "timesig", m_atoms_playhead);
-            
-            m_atoms_playhead[0] = static_cast<float>(infos.ppqPosition);
-            m_atoms_playhead[1] = static_cast<float>(infos.timeInSamples);
-            m_atoms_playhead.push_back(static_cast<float>(infos.timeInSeconds));
-            sendMessage("playhead", "position", m_atoms_playhead);
-            m_atoms_playhead.resize(1);
         }
+        if(all || infos.timeSigNumerator != last.timeSigNumerator || infos.timeSigDenominator != last.timeSigDenominator)
+        {
+            m_atoms_playhead2[0] = static_cast<float>(infos.timeSigNumerator);
+            m_atoms_playhead2[1] = static_cast<float>(infos.timeSigDenominator);
+            sendMessage("playhead", "timesig", m_atoms_playhead2);
+        }
+        if(all || ppq != last.ppqPosition || samples != last.timeInSamples)
+        {
+            m_atoms_playhead3[0] = static_cast<float>(ppq);
+            m_atoms_playhead3[1] = static_cast<float>(samples);
+            m_atoms_playhead3[2] = static_cast<float>(seconds);
+            sendMessage("playhead", "position", m_atoms_playhead3);
+        }
+        
+        last = infos;
+        last.ppqPosition    = ppq;
+        last.timeInSamples  = samples;
+        last.timeInSeconds  = seconds;
     }
 }
 
@@ -235,61 +455,87 @@ void CamomileAudioProcessor::sendMidiBuffer()
 {
     if(m_accepts_midi)
     {
-        for(auto it = m_midi_buffer_in.cbegin(); it != m_midi_buffer_in.cend(); ++it) {
-            auto const message = (*it).getMessage();
-            if(message.isNoteOn()) {
-                sendNoteOn(message.getChannel(), message.getNoteNumber(), message.getVelocity()); }
-            else if(message.isNoteOff()) {
-                sendNoteOn(message.getChannel(), message.getNoteNumber(), 0); }
-            else if(message.isController()) {
-                sendControlChange(message.getChannel(), message.getControllerNumber(), message.getControllerValue()); }
-            else if(message.isPitchWheel()) {
-                sendPitchBend(message.getChannel(), message.getPitchWheelValue() - 8192); }
-            else if(message.isChannelPressure()) {
-                sendAfterTouch(message.getChannel(), message.getChannelPressureValue()); }
-            else if(message.isAftertouch()) {
-                sendPolyAfterTouch(message.getChannel(), message.getNoteNumber(), message.getAfterTouchValue()); }
-            else if(message.isProgramChange()) {
-                sendProgramChange(message.getChannel(), message.getProgramChangeNumber()); }
-            else if(message.isSysEx()) {
-                for(int i = 0; i < message.getSysExDataSize(); ++i)  {
-                    sendSysEx(0, static_cast<int>(message.getSysExData()[i]));
-                }
-            }
-            else if(message.isMidiClock() || message.isMidiStart() || message.isMidiStop() || message.isMidiContinue() ||
-                    message.isActiveSense() || (message.getRawDataSize() == 1 && message.getRawData()[0] == 0xff)) {
-                for(int i = 0; i < message.getRawDataSize(); ++i)  {
-                    sendSysRealTime(0, static_cast<int>(message.getRawData()[i]));
-                }
-            }
-            
-            for(int i = 0; i < message.getRawDataSize(); i++)  {
-                sendMidiByte(0, static_cast<int>(message.getRawData()[i]));
-            }
+        m_midi_messages.clear();
+        m_midi_sizes.clear();
+        for(auto const metadata : m_midi_buffer_in)
+        {
+            m_midi_messages.push_back(metadata.data);
+            m_midi_sizes.push_back(metadata.numBytes);
+        }
+        if(!m_midi_messages.empty())
+        {
+            sendMidiMessages(m_midi_messages.data(), m_midi_sizes.data(), static_cast<int>(m_midi_messages.size()));
         }
         m_midi_buffer_in.clear();
     }
 }
 
-void CamomileAudioProcessor::processInternal()
+void CamomileAudioProcessor::processInternal(float const** inputs, float** outputs)
 {
+    // The MIDI events of the previous tick have been consumed, the
+    // messages processed below can already add new events.
+    if(m_produces_midi)
+    {
+        m_midi_buffer_out.clear();
+    }
+    swapPatchRequested(true);
+    // The instance is locked once for the inputs, the DSP and the outputs of the tick.
+    beginTick();
     sendMessagesFromQueue();
+    captureStateRequested();
     sendPlayhead();
     sendMidiBuffer();
     processMessages();
     sendParameters();
-    performDSP(m_audio_buffer_in.data(), m_audio_buffer_out.data());
+    const int nins  = static_cast<int>(m_audio_channels_in.size());
+    const int nouts = static_cast<int>(m_audio_channels_out.size());
+    if(!inputs || !outputs)
+    {
+        for(int j = 0; j < nins; ++j)
+        {
+            m_audio_channels_in[j] = m_audio_buffer_in.data()+j*m_audio_blocksize;
+        }
+        for(int j = 0; j < nouts; ++j)
+        {
+            m_audio_channels_out[j] = m_audio_buffer_out.data()+j*m_audio_blocksize;
+        }
+        inputs  = m_audio_channels_in.data();
+        outputs = m_audio_channels_out.data();
+    }
+    if(m_oversampler)
+    {
+        // Pd reads its inputs from and writes its outputs to the
+        // oversampled block, then the result is decimated.
+        auto block = m_oversampler->processSamplesUp(dsp::AudioBlock<float const>(inputs, static_cast<size_t>(nins), static_cast<size_t>(m_audio_blocksize)));
+        for(int j = 0; j < nins; ++j)
+        {
+            m_oversampled_in[j] = block.getChannelPointer(static_cast<size_t>(j));
+        }
+        for(int j = 0; j < nouts; ++j)
+        {
+            m_oversampled_out[j] = block.getChannelPointer(static_cast<size_t>(j));
+        }
+        performDSP(m_oversampled_in.data(), m_oversampled_out.data(), nins, nouts, Instance::getBlockSize());
+        dsp::AudioBlock<float> output(outputs, static_cast<size_t>(nouts), static_cast<size_t>(m_audio_blocksize));
+        m_oversampler->processSamplesDown(output);
+    }
+    else
+    {
+        performDSP(inputs, outputs, nins, nouts, Instance::getBlockSize());
+    }
+    endTick();
+    fadePatchRequested();
     
     //////////////////////////////////////////////////////////////////////////////////////////
     //                                          MIDI OUT                                    //
     //////////////////////////////////////////////////////////////////////////////////////////
     if(m_produces_midi)
     {
-        m_midibyte_index = 0;
-        m_midibyte_buffer[0] = 0;
-        m_midibyte_buffer[1] = 0;
-        m_midibyte_buffer[2] = 0;
-        m_midi_buffer_out.clear();
+        // A SysEx message can be streamed over several ticks.
+        if(!m_midibyte_issysex)
+        {
+            m_midibyte_index = 0;
+        }
         processMidi();
     }
 }
@@ -297,9 +543,12 @@ void CamomileAudioProcessor::processInternal()
 void CamomileAudioProcessor::processBlock(AudioSampleBuffer& buffer, MidiBuffer& midiMessages)
 {
     ScopedNoDenormals noDenormals;
-    const int blocksize = Instance::getBlockSize();
+    const int blocksize = m_audio_blocksize;
     const int nsamples  = buffer.getNumSamples();
-    const int adv       = m_audio_advancement >= 64 ? 0 : m_audio_advancement;
+    const double samplerate = getSampleRate();
+    m_params_ramp       = samplerate > 0. ? static_cast<float>(nsamples * 1000.0 / samplerate) : 0.f;
+    updatePlayhead();
+    const int adv       = m_audio_advancement >= blocksize ? 0 : m_audio_advancement;
     const int nleft     = blocksize - adv;
     const int nins      = getTotalNumInputChannels();
     const int nouts     = getTotalNumOutputChannels();
@@ -316,6 +565,49 @@ void CamomileAudioProcessor::processBlock(AudioSampleBuffer& buffer, MidiBuffer&
     
     //////////////////////////////////////////////////////////////////////////////////////////
     
+    // If the number of samples is a multiple of the block size, Pd reads
+    // and writes the channels of the buffer directly, without delay.
+    if(m_audio_direct)
+    {
+        if(nsamples % blocksize == 0)
+        {
+            MidiBuffer const& midiin = midi_produce ? m_midi_buffer_temp : midiMessages;
+            if(midi_produce)
+            {
+                m_midi_buffer_temp.swapWith(midiMessages);
+                midiMessages.clear();
+            }
+            for(int pos = 0; pos < nsamples; pos += blocksize)
+            {
+                for(size_t j = 0; j < m_audio_channels_in.size(); ++j)
+                {
+                    m_audio_channels_in[j] = bufferin[j]+pos;
+                }
+                for(size_t j = 0; j < m_audio_channels_out.size(); ++j)
+                {
+                    m_audio_channels_out[j] = bufferout[j]+pos;
+                }
+                if(midi_consume)
+                {
+                    m_midi_buffer_in.addEvents(midiin, pos, blocksize, -pos);
+                }
+                m_audio_advancement = 0;
+                m_playhead_offset = pos;
+                processInternal(m_audio_channels_in.data(), m_audio_channels_out.data());
+                if(midi_produce)
+                {
+                    midiMessages.addEvents(m_midi_buffer_out, 0, blocksize, pos);
+                }
+            }
+            return;
+        }
+        // The host doesn't respect the block size announced, so the
+        // samples are buffered until the next call to prepareToPlay.
+        m_audio_direct = false;
+        m_audio_advancement = 0;
+        updateLatencyAsync();
+    }
+    
     // If the current number of samples in this block
     // is inferior to the number of samples required
     if(nsamples < nleft)
@@ -378,6 +670,7 @@ void CamomileAudioProcessor::processBlock(AudioSampleBuffer& buffer, MidiBuffer&
             midiMessages.addEvents(m_midi_buffer_out, adv, nleft, -adv);
         }
         m_audio_advancement = 0;
+        m_playhead_offset = nleft - blocksize;
         processInternal();
         
         //////////////////////////////////////////////////////////////////////////////////////
@@ -405,6 +698,7 @@ void CamomileAudioProcessor::processBlock(AudioSampleBuffer& buffer, MidiBuffer&
             {
                 midiMessages.addEvents(m_midi_buffer_out, 0, blocksize, pos);
             }
+            m_playhead_offset = pos;
             processInternal();
             pos += blocksize;
         }
@@ -444,10 +738,17 @@ void CamomileAudioProcessor::processBlockBypassed (AudioBuffer<float>& buffer, M
 {
     if(m_auto_bypass)
     {
+        swapPatchRequested(false);
+        updatePlayhead();
+        beginTick();
         sendMessagesFromQueue();
+        captureStateRequested();
         sendPlayhead();
         sendParameters();
         processMessages();
+        publishGuis();
+        endTick();
+        fadePatchRequested();
         const int nsamples  = buffer.getNumSamples();
         const int nins      = getTotalNumInputChannels();
         const int nouts     = getTotalNumOutputChannels();
@@ -473,8 +774,11 @@ void CamomileAudioProcessor::messageEnqueued()
     {
         sendMessagesFromQueue();
         processMessages();
+        publishGuis();
     }
-    else
+    // The audio thread sends the messages at the next tick, so the message thread
+    // only competes for the callback lock when the host stopped the processing.
+    else if(isSendingStalled())
     {
         const CriticalSection& cs = getCallbackLock();
         if(cs.tryEnter())
@@ -497,133 +801,6 @@ AudioProcessorEditor* CamomileAudioProcessor::createEditor()
     return new CamomileEditor(*this);
 }
 
-void CamomileAudioProcessor::parseSaveInformation(const std::vector<pd::Atom>& list)
-{
-    if(m_temp_xml)
-    {
-        XmlElement* patch = m_temp_xml->getChildByName("patch");
-        if(!patch)
-        {
-            patch = m_temp_xml->createNewChildElement("patch");
-            if(!patch)
-            {
-                add(ConsoleLevel::Error, "can't allocate memory for saving plugin state.");
-                return;
-            }
-        }
-        const int nchilds = patch->getNumChildElements();
-        XmlElement* preset = patch->createNewChildElement(String("list") + String(nchilds+1));
-        if(preset)
-        {
-            for(size_t i = 0; i < list.size(); ++i)
-            {
-                if(list[i].isFloat()) {
-                    preset->setAttribute(String("float") + String(i+1), list[i].getFloat()); }
-                else if(list[i].isSymbol())  {
-                    preset->setAttribute(String("string") + String(i+1), String(list[i].getSymbol())); }
-                else {
-                    preset->setAttribute(String("atom") + String(i+1), String("unknown")); }
-            }
-        }
-        else
-        {
-            add(ConsoleLevel::Error, "can't allocate memory for saving plugin state.");
-        }
-    }
-    else
-    {
-        add(ConsoleLevel::Error, "camomile save method should be called after plugin save notification.");
-    }
-}
-
-void CamomileAudioProcessor::loadInformation(XmlElement const& xml)
-{
-    bool loaded = false;
-    XmlElement const* patch = xml.getChildByName(juce::StringRef("patch"));
-    if(patch)
-    {
-        const int nlists = patch->getNumChildElements();
-        std::vector<pd::Atom> vec;
-        for(int i = 0; i < nlists; ++i)
-        {
-            XmlElement const* list = patch->getChildElement(i);
-            if(list)
-            {
-                const int natoms = list->getNumAttributes();
-                vec.resize(natoms);
-                
-                for(int j = 0; j < natoms; ++j)
-                {
-                    String const& name = list->getAttributeName(j);
-                    if(name.startsWith("float")) {
-                        vec[j] = static_cast<float>(list->getDoubleAttribute(name)); }
-                    else if(name.startsWith("string")){
-                        vec[j] = list->getStringAttribute(name).toStdString(); }
-                    else {
-                        vec[j] = "unknown"; }
-                }
-                
-                sendList("load", vec);
-                loaded = true;
-            }
-        }
-    }
-    
-    if(!loaded)
-    {
-        sendBang("load");
-    }
-}
-
-void CamomileAudioProcessor::getStateInformation(MemoryBlock& destData)
-{
-    suspendProcessing(true);
-    XmlElement xml(String("CamomileSettings"));
-    m_temp_xml = &xml;
-    CamomileAudioParameter::saveStateInformation(xml, getParameters());
-    sendBang("save");
-    processMessages();
-    copyXmlToBinary(xml, destData);
-    m_temp_xml = nullptr;
-    XmlElement* cbounds = xml.createNewChildElement("console");
-    if(cbounds)
-    {
-        cbounds->setAttribute(String("x"), m_console_bounds.getX());
-        cbounds->setAttribute(String("y"), m_console_bounds.getX());
-        cbounds->setAttribute(String("width"), m_console_bounds.getWidth());
-        cbounds->setAttribute(String("height"), m_console_bounds.getHeight());
-    }
-    
-    suspendProcessing(false);
-}
-
-void CamomileAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
-{
-    suspendProcessing(true);
-    auto xml(getXmlFromBinary(data, sizeInBytes));
-    if(xml && xml->hasTagName("CamomileSettings"))
-    {
-        if(CamomileEnvironment::wantsAutoProgram())
-        {
-            CamomileAudioParameter::loadStateInformation(*xml, getParameters());            
-        }
-        loadInformation(*xml);
-        XmlElement const* cbounds = xml->getChildByName(juce::StringRef("console"));
-        if(cbounds)
-        {
-            m_console_bounds.setX(cbounds->getIntAttribute(String("x")));
-            m_console_bounds.setY(cbounds->getIntAttribute(String("y")));
-            m_console_bounds.setWidth(cbounds->getIntAttribute(String("width")));
-            m_console_bounds.setHeight(cbounds->getIntAttribute(String("height")));
-        }
-    }
-    else
-    {
-        sendBang("load");
-    }
-    suspendProcessing(false);
-}
-
 void CamomileAudioProcessor::updateTrackProperties(const TrackProperties& properties)
 {
     m_track_properties = properties;
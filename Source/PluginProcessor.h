@@ -15,7 +15,7 @@
 //                                      PROCESSOR                                           //
 // ======================================================================================== //
 
-class CamomileAudioProcessor : public AudioProcessor, public pd::Instance, public CamomileConsole, public CamomileFileWatcher
+class CamomileAudioProcessor : public AudioProcessor, public pd::Instance, public CamomileConsole, public CamomileFileWatcher, private AsyncUpdater, private Timer
 {
 public:
     CamomileAudioProcessor();
@@ -37,7 +37,8 @@ public:
     bool isBusesLayoutSupported (const BusesLayout& layouts) const override;
 private:
     static BusesProperties getDefaultBusesProperties(const bool canonical);
-    void sendCurrentBusesLayoutInformation();
+    //! @brief Sends the layout of the buses to the current patch or to the patch loaded in the new instance.
+    void sendCurrentBusesLayoutInformation(const bool pending = false);
     void logBusesLayoutsInformation();
     bool canAddBus (bool isInput) const override;
     bool canRemoveBus (bool isInput) const override;
@@ -85,6 +86,7 @@ public:
     typedef std::array<std::string, 3> MessageGui;
     bool dequeueGui(MessageGui& message);
 
+    void collectFiles() override;
     void fileChanged() override;
     void reloadPatch();
     
@@ -102,7 +104,25 @@ public:
     };
     
 private:
-    void loadInformation(XmlElement const& xml);
+    //! @brief Sends the lists of the saved state to the current patch or to the patch loaded in the new instance.
+    void loadInformation(std::vector<std::vector<pd::Atom>> const& lists, const bool pending = false);
+    //! @brief Captures the lists saved by the patch, the memory can only grow if the processing is suspended.
+    void captureState(bool growable);
+    //! @brief Captures the state within the next tick of the audio thread, returns false if it failed.
+    bool captureStateAsync();
+    //! @brief Captures the state if the message thread requested it.
+    void captureStateRequested();
+    //! @brief Captures the state and converts it to the lists saved by the patch.
+    void captureLists(std::vector<std::vector<pd::Atom>>& lists);
+    
+    //! @brief Swaps the instances within the next tick of the audio thread, returns false if it failed.
+    bool swapPatchAsync();
+    //! @brief Swaps the instances if the message thread requested it.
+    void swapPatchRequested(const bool crossfade);
+    //! @brief Notifies the message thread at the end of the crossfade that follows the swap.
+    void fadePatchRequested();
+    //! @brief Swaps the instances and resynchronizes the parameters and the playhead.
+    void swapPatchInternal(const bool crossfade);
     
     void parseProgram(const std::vector<pd::Atom>& list);
     void parseSaveInformation(const std::vector<pd::Atom>& list);
@@ -111,12 +131,26 @@ private:
     void parseArray(const std::vector<pd::Atom>& list);
     void parseGui(const std::vector<pd::Atom>& list);
     void parseAudio(const std::vector<pd::Atom>& list);
-    
-    
-    void processInternal();
+    void parseSysEx(const std::vector<pd::Atom>& list);
+    
+    
+    void processInternal(float const** inputs = nullptr, float** outputs = nullptr);
+    void updateLatency();
+    //! @brief Requests the message thread to notify the host of the new latency.
+    //! @details The method can be called by the audio thread.
+    void updateLatencyAsync();
+    int computeLatency() const;
+    void handleAsyncUpdate() override;
+    //! @brief Moves the prints of Pd and the messages to the console.
+    //! @details The console is drained even if no editor displays it, so the oldest messages
+    //! are evicted rather than the new ones dropped.
+    void timerCallback() override;
     void sendParameters();
     void sendPlayhead();
+    void updatePlayhead();
     void sendMidiBuffer();
+    //! @brief Gets the position in the output MIDI buffer of the event received from Pd.
+    int getMidiPosition() const noexcept;
     
     typedef moodycamel::ReaderWriterQueue<MessageGui> QueueGui;
     
@@ -125,31 +159,92 @@ private:
     bool const              m_produces_midi     = false;
     bool const              m_is_midi_effect    = false;
     bool const              m_auto_bypass       = true;
+    bool const              m_params_batch      = false;
     double const            m_tail_length       = 0.;
     
     AudioProcessorParameter* m_bypass_param     = nullptr;
     std::vector<pd::Atom>    m_atoms_param;
+    std::vector<pd::Atom>    m_atoms_params;
     std::vector<pd::Atom>    m_atoms_playhead;
+    std::vector<pd::Atom>    m_atoms_playhead2;
+    std::vector<pd::Atom>    m_atoms_playhead3;
+    
+    AudioPlayHead::CurrentPositionInfo m_playhead_infos;
+    AudioPlayHead::CurrentPositionInfo m_playhead_last;
+    bool                     m_playhead_valid   = false;
+    bool                     m_playhead_sync    = true;
+    int                      m_playhead_offset  = 0;
     
     int                      m_audio_advancement;
     std::vector<float>       m_audio_buffer_in;
     std::vector<float>       m_audio_buffer_out;
+    bool                     m_audio_direct     = false;
+    int                      m_audio_latency    = 0;
+    std::atomic<int>         m_audio_latency_async {0};
+    int                      m_audio_blocksize  = 64;
+    std::vector<float const*> m_audio_channels_in;
+    std::vector<float*>      m_audio_channels_out;
+    
+    std::unique_ptr<dsp::Oversampling<float>> m_oversampler;
+    std::vector<float const*> m_oversampled_in;
+    std::vector<float*>      m_oversampled_out;
     
     MidiBuffer               m_midi_buffer_in;
     MidiBuffer               m_midi_buffer_out;
     MidiBuffer               m_midi_buffer_temp;
+    std::vector<uint8 const*> m_midi_messages;
+    std::vector<int>         m_midi_sizes;
     
     bool                     m_midibyte_issysex = false;
-    uint8                    m_midibyte_buffer[512];
+    std::vector<uint8>       m_midibyte_buffer;
     size_t                   m_midibyte_index = 0;
+    std::vector<uint8>       m_sysex_buffer;
     
     
     int m_program_current    = 0;
     std::vector<std::string> m_programs;
     std::vector<bool>        m_params_states;
+    std::vector<uint32>      m_params_generations;
+    bool                     m_params_sync      = true;
+    float                    m_params_ramp      = 0.f;
     QueueGui                 m_queue_gui = QueueGui(64);
     TrackProperties          m_track_properties;
-    XmlElement*              m_temp_xml;
+    //! @brief The lists saved by the patch in preallocated memory.
+    //! @details An atom refers to a float or to the offset of a symbol in the text.
+    struct SavedState
+    {
+        struct atom
+        {
+            float value;
+            int   symbol;
+        };
+        std::vector<atom>   atoms;
+        std::vector<char>   text;
+        std::vector<size_t> sizes;
+        bool                growable = true;
+        bool                overflow = false;
+    };
+    
+    static constexpr size_t state_atoms = 65536;
+    static constexpr size_t state_text  = 65536;
+    static constexpr size_t state_lists = 4096;
+    static constexpr int    state_timeout = 500;
+    
+    SavedState               m_state;
+    bool                     m_state_capturing  = false;
+    std::atomic<bool>        m_state_requested  {false};
+    WaitableEvent            m_state_captured;
+    CriticalSection          m_state_lock;
+    
+    static constexpr int     reload_fade = 20;
+    
+    std::vector<std::vector<pd::Atom>> m_reload_lists;
+    std::atomic<bool>        m_reload_requested {false};
+    WaitableEvent            m_reload_swapped;
+    std::atomic<bool>        m_reload_fading {false};
+    WaitableEvent            m_reload_faded;
+    
+    static constexpr int     console_interval = 100;
     
     Rectangle<int>           m_console_bounds = Rectangle<int>(50, 50, 300, 370);
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (CamomileAudioProcessor)
@@ -201,7 +201,7 @@ bool CamomileAudioProcessor::CamomileAudioProcessor::canRemoveBus(bool isInput)
 //                              SEND CURRENT BUSES LAYOUT INFORMATION                       //
 //////////////////////////////////////////////////////////////////////////////////////////////
 
-void CamomileAudioProcessor::sendCurrentBusesLayoutInformation()
+void CamomileAudioProcessor::sendCurrentBusesLayoutInformation(const bool pending)
 {
     const int nBuses = std::max(getBusCount(true), getBusCount(false));
     for(int i = 0; i < nBuses; ++i)
@@ -210,11 +210,25 @@ void CamomileAudioProcessor::sendCurrentBusesLayoutInformation()
         AudioProcessor::Bus const* outBus = getBus(false, i);
         if(inBus && inBus->isEnabled())
         {
-            sendList("bus", CamomileBusesLayoutHelper::getBusInformation(*inBus));
+            if(pending)
+            {
+                sendPendingList("bus", CamomileBusesLayoutHelper::getBusInformation(*inBus));
+            }
+            else
+            {
+                sendList("bus", CamomileBusesLayoutHelper::getBusInformation(*inBus));
+            }
         }
         if(outBus && outBus->isEnabled())
         {
-            sendList("bus", CamomileBusesLayoutHelper::getBusInformation(*outBus));
+            if(pending)
+            {
+                sendPendingList("bus", CamomileBusesLayoutHelper::getBusInformation(*outBus));
+            }
+            else
+            {
+                sendList("bus", CamomileBusesLayoutHelper::getBusInformation(*outBus));
+            }
         }
     }
 }
@@ -11,91 +11,79 @@
 //                                          MIDI METHODS                                    //
 //////////////////////////////////////////////////////////////////////////////////////////////
 
+int CamomileAudioProcessor::getMidiPosition() const noexcept
+{
+    // The offset is given in samples of Pd that can be oversampled.
+    const int offset = getMidiOffset() * m_audio_blocksize / Instance::getBlockSize();
+    return m_audio_advancement + std::min(offset, m_audio_blocksize - 1);
+}
+
 void CamomileAudioProcessor::receiveNoteOn(const int channel, const int pitch, const int velocity)
 {
     if(velocity == 0)
     {
-        m_midi_buffer_out.addEvent(MidiMessage::noteOff(channel, pitch, uint8(0)), m_audio_advancement);
+        m_midi_buffer_out.addEvent(MidiMessage::noteOff(channel, pitch, uint8(0)), getMidiPosition());
     }
     else
     {
-        m_midi_buffer_out.addEvent(MidiMessage::noteOn(channel, pitch, static_cast<uint8>(velocity)), m_audio_advancement);
+        m_midi_buffer_out.addEvent(MidiMessage::noteOn(channel, pitch, static_cast<uint8>(velocity)), getMidiPosition());
     }
 }
 
 void CamomileAudioProcessor::receiveControlChange(const int channel, const int controller, const int value)
 {
-    m_midi_buffer_out.addEvent(MidiMessage::controllerEvent(channel, controller, value), m_audio_advancement);
+    m_midi_buffer_out.addEvent(MidiMessage::controllerEvent(channel, controller, value), getMidiPosition());
 }
 
 void CamomileAudioProcessor::receiveProgramChange(const int channel, const int value)
 {
-    m_midi_buffer_out.addEvent(MidiMessage::programChange(channel, value), m_audio_advancement);
+    m_midi_buffer_out.addEvent(MidiMessage::programChange(channel, value), getMidiPosition());
 }
 
 void CamomileAudioProcessor::receivePitchBend(const int channel, const int value)
 {
-    m_midi_buffer_out.addEvent(MidiMessage::pitchWheel(channel, value + 8192), m_audio_advancement);
+    m_midi_buffer_out.addEvent(MidiMessage::pitchWheel(channel, value + 8192), getMidiPosition());
 }
 
 void CamomileAudioProcessor::receiveAftertouch(const int channel, const int value)
 {
-    m_midi_buffer_out.addEvent(MidiMessage::channelPressureChange(channel, value), m_audio_advancement);
+    m_midi_buffer_out.addEvent(MidiMessage::channelPressureChange(channel, value), getMidiPosition());
 }
 
 void CamomileAudioProcessor::receivePolyAftertouch(const int channel, const int pitch, const int value)
 {
-    m_midi_buffer_out.addEvent(MidiMessage::aftertouchChange(channel, pitch, value), m_audio_advancement);
+    m_midi_buffer_out.addEvent(MidiMessage::aftertouchChange(channel, pitch, value), getMidiPosition());
 }
 
 void CamomileAudioProcessor::receiveMidiByte(const int port, const int byte)
 {
-#if 0
-    if(m_midibyte_index == 0)
+    // The SysEx messages are assembled with their framing bytes so they
+    // can be copied directly in the MIDI buffer.
+    if(m_midibyte_index >= m_midibyte_buffer.size())
     {
-        add(ConsoleLevel::Error, "Process Send Midi Bytes ----");
+        m_midibyte_buffer.resize(std::max(m_midibyte_buffer.size() * 2, static_cast<size_t>(512)));
     }
-    add(ConsoleLevel::Error,  std::to_string(byte));
-#endif
     if(m_midibyte_issysex)
     {
+        m_midibyte_buffer[m_midibyte_index++] = static_cast<uint8>(byte);
         if(byte == 0xf7)
         {
-#if 0
-            add(ConsoleLevel::Error,  std::to_string(byte));
-            add(ConsoleLevel::Error, "End Sys Ex " + std::to_string(m_midibyte_index) + "----");
-#endif
-            m_midi_buffer_out.addEvent(MidiMessage::createSysExMessage(m_midibyte_buffer, static_cast<int>(m_midibyte_index)), m_audio_advancement);
+            m_midi_buffer_out.addEvent(m_midibyte_buffer.data(), static_cast<int>(m_midibyte_index), getMidiPosition());
             m_midibyte_index = 0;
             m_midibyte_issysex = false;
         }
-        else
-        {
-#if 0
-            add(ConsoleLevel::Error,  std::to_string(byte));
-#endif
-            m_midibyte_buffer[m_midibyte_index++] = static_cast<uint8> (byte);
-            if(m_midibyte_index == 512)
-            {
-                add(ConsoleLevel::Fatal, "SysEx message cannot exceed 512 bytes, please send a message to the developer to tell him that the size should be dynamic!");
-                m_midibyte_index = 511;
-            }
-        }
     }
     else if(m_midibyte_index == 0 && byte == 0xf0)
     {
-#if 0
-        add(ConsoleLevel::Error, "Start Sys Ex ----");
-        add(ConsoleLevel::Error,  std::to_string(byte));
-#endif
+        m_midibyte_buffer[m_midibyte_index++] = static_cast<uint8>(byte);
         m_midibyte_issysex = true;
     }
     else
     {
-        m_midibyte_buffer[m_midibyte_index++] = static_cast<uint8> (byte);
+        m_midibyte_buffer[m_midibyte_index++] = static_cast<uint8>(byte);
         if(m_midibyte_index >= 3)
         {
-            m_midi_buffer_out.addEvent(MidiMessage(m_midibyte_buffer, 3), m_audio_advancement);
+            m_midi_buffer_out.addEvent(m_midibyte_buffer.data(), 3, getMidiPosition());
             m_midibyte_index = 0;
         }
     }
@@ -242,6 +230,21 @@ void CamomileAudioProcessor::receiveMessage(const std::string& msg, const std::v
     {
         parseAudio(list);
     }
+    else if(msg == "sysex")
+    {
+        parseSysEx(list);
+    }
+    else if(msg == "stderr")
+    {
+        if(list.size() == 1 && list[0].isFloat())
+        {
+            setPrintMirror(list[0].getFloat() != 0.f);
+        }
+        else
+        {
+            add(ConsoleLevel::Error, "camomile stderr method expects a float");
+        }
+    }
     else {  add(ConsoleLevel::Error, "camomile unknow message : " + msg); }
 }
 
@@ -420,7 +423,8 @@ void CamomileAudioProcessor::parseAudio(const std::vector<pd::Atom>& list)
                     const int latency = static_cast<int>(list[1].getFloat());
                     if(latency >= 0)
                     {
-                        setLatencySamples(latency + Instance::getBlockSize());
+                        m_audio_latency = latency;
+                        updateLatencyAsync();
                         if(list.size() > 2)
                         {
                             add(ConsoleLevel::Error, "camomile audio method: latency option extra arguments");
@@ -456,3 +460,46 @@ void CamomileAudioProcessor::parseAudio(const std::vector<pd::Atom>& list)
     }
 }
 
+
+void CamomileAudioProcessor::parseSysEx(const std::vector<pd::Atom>& list)
+{
+    if(!m_produces_midi)
+    {
+        add(ConsoleLevel::Error, "camomile sysex method: the plugin doesn't produce MIDI");
+        return;
+    }
+    if(list.empty())
+    {
+        add(ConsoleLevel::Error, "camomile sysex method: expects arguments");
+        return;
+    }
+    // The framing bytes are optional in the list.
+    const bool start = list.front().isFloat() && static_cast<int>(list.front().getFloat()) == 0xf0;
+    const bool end   = list.back().isFloat() && static_cast<int>(list.back().getFloat()) == 0xf7;
+    m_sysex_buffer.clear();
+    if(!start)
+    {
+        m_sysex_buffer.push_back(0xf0);
+    }
+    for(size_t i = 0; i < list.size(); ++i)
+    {
+        if(!list[i].isFloat())
+        {
+            add(ConsoleLevel::Error, "camomile sysex method: arguments must be bytes");
+            return;
+        }
+        const int byte = static_cast<int>(list[i].getFloat());
+        const bool framing = (i == 0 && start) || (i == list.size() - 1 && end);
+        if(byte < 0 || (byte > 0x7f && !framing))
+        {
+            add(ConsoleLevel::Error, "camomile sysex method: data bytes must be between 0 and 127");
+            return;
+        }
+        m_sysex_buffer.push_back(static_cast<uint8>(byte));
+    }
+    if(!end)
+    {
+        m_sysex_buffer.push_back(0xf7);
+    }
+    m_midi_buffer_out.addEvent(m_sysex_buffer.data(), static_cast<int>(m_sysex_buffer.size()), getMidiPosition());
+}
@@ -0,0 +1,399 @@
+/*
+ // Copyright (c) 2015-2018 Pierre Guillot.
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+*/
+
+#include "PluginProcessor.h"
+#include "PluginParameter.h"
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+//                                  CAMOMILE STATE HELPER                                   //
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+//! @brief The binary format of the state.
+//! @details The state starts with the magic number and the version, followed by the values
+//! of the parameters, the bounds of the console and the lists saved by the patch. The
+//! consecutive floats of a list are stored in raw blocks so large presets such as arrays
+//! are copied without conversion. The integers and the floats are little endian.
+class CamomileStateHelper
+{
+public:
+    using lists_t = std::vector<std::vector<pd::Atom>>;
+
+    static void write(MemoryOutputStream& stream, std::vector<float> const& params,
+                      Rectangle<int> const& bounds, lists_t const& lists)
+    {
+        stream.writeInt(magic);
+        stream.writeInt(version);
+        stream.writeInt(static_cast<int>(params.size()));
+        writeFloats(stream, params.data(), params.size());
+        stream.writeInt(bounds.getX());
+        stream.writeInt(bounds.getY());
+        stream.writeInt(bounds.getWidth());
+        stream.writeInt(bounds.getHeight());
+        stream.writeInt(static_cast<int>(lists.size()));
+        std::vector<float> floats;
+        for(auto const& list : lists)
+        {
+            stream.writeInt(static_cast<int>(list.size()));
+            size_t i = 0;
+            while(i < list.size())
+            {
+                if(list[i].isFloat())
+                {
+                    floats.clear();
+                    for(; i < list.size() && list[i].isFloat(); ++i)
+                    {
+                        floats.push_back(list[i].getFloat());
+                    }
+                    stream.writeByte(atom_floats);
+                    stream.writeInt(static_cast<int>(floats.size()));
+                    writeFloats(stream, floats.data(), floats.size());
+                }
+                else
+                {
+                    stream.writeByte(atom_symbol);
+                    stream.writeString(list[i].isSymbol() ? String(list[i].getSymbol()) : String("unknown"));
+                    ++i;
+                }
+            }
+        }
+    }
+
+    //! @brief Reads a binary state, returns false if the data is not a valid binary state.
+    static bool read(void const* data, size_t size, std::vector<float>& params,
+                     Rectangle<int>& bounds, lists_t& lists)
+    {
+        MemoryInputStream stream(data, size, false);
+        if(size < sizeof(int) * 2 || stream.readInt() != magic || stream.readInt() != version)
+        {
+            return false;
+        }
+        int const nparams = stream.readInt();
+        if(!isValidSize(stream, nparams, sizeof(float)))
+        {
+            return false;
+        }
+        params.resize(static_cast<size_t>(nparams));
+        if(!readFloats(stream, params.data(), params.size()))
+        {
+            return false;
+        }
+        int const x = stream.readInt();
+        int const y = stream.readInt();
+        int const w = stream.readInt();
+        int const h = stream.readInt();
+        bounds.setBounds(x, y, w, h);
+        int const nlists = stream.readInt();
+        if(!isValidSize(stream, nlists, sizeof(int)))
+        {
+            return false;
+        }
+        std::vector<float> floats;
+        lists.resize(static_cast<size_t>(nlists));
+        for(auto& list : lists)
+        {
+            int const natoms = stream.readInt();
+            if(!isValidSize(stream, natoms, 1))
+            {
+                return false;
+            }
+            list.clear();
+            list.reserve(static_cast<size_t>(natoms));
+            while(list.size() < static_cast<size_t>(natoms))
+            {
+                auto const type = stream.readByte();
+                if(type == atom_floats)
+                {
+                    int const nfloats = stream.readInt();
+                    if(!isValidSize(stream, nfloats, sizeof(float)) || list.size() + static_cast<size_t>(nfloats) > static_cast<size_t>(natoms))
+                    {
+                        return false;
+                    }
+                    auto const offset = list.size();
+                    floats.resize(static_cast<size_t>(nfloats));
+                    if(!readFloats(stream, floats.data(), floats.size()))
+                    {
+                        return false;
+                    }
+                    list.resize(offset + floats.size());
+                    for(size_t i = 0; i < floats.size(); ++i)
+                    {
+                        list[offset + i] = floats[i];
+                    }
+                }
+                else if(type == atom_symbol && !stream.isExhausted())
+                {
+                    list.push_back(stream.readString().toStdString());
+                }
+                else
+                {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    //! @brief Reads the lists of the XML state of the previous versions.
+    static void read(XmlElement const& xml, lists_t& lists)
+    {
+        XmlElement const* patch = xml.getChildByName(juce::StringRef("patch"));
+        if(patch)
+        {
+            const int nlists = patch->getNumChildElements();
+            for(int i = 0; i < nlists; ++i)
+            {
+                XmlElement const* list = patch->getChildElement(i);
+                if(list)
+                {
+                    const int natoms = list->getNumAttributes();
+                    std::vector<pd::Atom> vec(static_cast<size_t>(natoms));
+                    for(int j = 0; j < natoms; ++j)
+                    {
+                        String const& name = list->getAttributeName(j);
+                        if(name.startsWith("float")) {
+                            vec[j] = static_cast<float>(list->getDoubleAttribute(name)); }
+                        else if(name.startsWith("string")){
+                            vec[j] = list->getStringAttribute(name).toStdString(); }
+                        else {
+                            vec[j] = "unknown"; }
+                    }
+                    lists.push_back(std::move(vec));
+                }
+            }
+        }
+    }
+
+private:
+    static constexpr int   magic       = 0x74536d43; // "CmSt"
+    static constexpr int   version     = 1;
+    static constexpr uint8 atom_floats = 0;
+    static constexpr uint8 atom_symbol = 1;
+
+    static bool isValidSize(MemoryInputStream& stream, int const size, size_t const elemsize)
+    {
+        return size >= 0 && static_cast<int64>(size) * static_cast<int64>(elemsize) <= stream.getNumBytesRemaining();
+    }
+
+    static void writeFloats(MemoryOutputStream& stream, float const* values, size_t const size)
+    {
+#if JUCE_LITTLE_ENDIAN
+        stream.write(values, size * sizeof(float));
+#else
+        for(size_t i = 0; i < size; ++i) { stream.writeFloat(values[i]); }
+#endif
+    }
+
+    static bool readFloats(MemoryInputStream& stream, float* values, size_t const size)
+    {
+#if JUCE_LITTLE_ENDIAN
+        auto const nbytes = static_cast<int>(size * sizeof(float));
+        return stream.read(values, nbytes) == nbytes;
+#else
+        for(size_t i = 0; i < size; ++i) { values[i] = stream.readFloat(); }
+        return !stream.isExhausted() || size == 0;
+#endif
+    }
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+//                                      STATE                                               //
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+void CamomileAudioProcessor::parseSaveInformation(const std::vector<pd::Atom>& list)
+{
+    if(!m_state_capturing)
+    {
+        add(ConsoleLevel::Error, "camomile save method should be called after plugin save notification.");
+        return;
+    }
+    // On the audio thread, the lists that don't fit in the preallocated memory are
+    // dropped and the message thread captures the state again with suspended processing.
+    auto& state = m_state;
+    size_t length = 0;
+    for(auto const& atom : list)
+    {
+        length += atom.isFloat() ? 0 : atom.getSymbol().size() + 1;
+    }
+    if(!state.growable && (state.sizes.size() == state.sizes.capacity() ||
+                           state.atoms.size() + list.size() > state.atoms.capacity() ||
+                           state.text.size() + length > state.text.capacity()))
+    {
+        state.overflow = true;
+        return;
+    }
+    for(auto const& atom : list)
+    {
+        if(atom.isFloat())
+        {
+            state.atoms.push_back({atom.getFloat(), -1});
+        }
+        else
+        {
+            state.atoms.push_back({0.f, static_cast<int>(state.text.size())});
+            state.text.insert(state.text.end(), atom.getSymbol().begin(), atom.getSymbol().end());
+            state.text.push_back('\0');
+        }
+    }
+    state.sizes.push_back(list.size());
+}
+
+void CamomileAudioProcessor::loadInformation(std::vector<std::vector<pd::Atom>> const& lists, const bool pending)
+{
+    // The patch loaded in the new instance isn't processed yet, so
+    // the lists are sent to it without waiting for the audio thread.
+    if(pending)
+    {
+        for(auto const& list : lists)
+        {
+            sendPendingList("load", list);
+        }
+        if(lists.empty())
+        {
+            sendPendingBang("load");
+        }
+        return;
+    }
+    // Only the delivery of the lists to Pd is synchronized with the
+    // audio thread, the state has already been decoded.
+    const ScopedLock lock(getCallbackLock());
+    for(auto const& list : lists)
+    {
+        sendList("load", list);
+    }
+    if(lists.empty())
+    {
+        sendBang("load");
+    }
+}
+
+void CamomileAudioProcessor::captureState(bool growable)
+{
+    m_state.atoms.clear();
+    m_state.text.clear();
+    m_state.sizes.clear();
+    m_state.growable = growable;
+    m_state.overflow = false;
+    m_state_capturing = true;
+    sendBang("save");
+    processMessages();
+    m_state_capturing = false;
+}
+
+void CamomileAudioProcessor::captureStateRequested()
+{
+    if(m_state_requested.load() && m_state_requested.exchange(false))
+    {
+        captureState(false);
+        m_state_captured.signal();
+    }
+}
+
+bool CamomileAudioProcessor::captureStateAsync()
+{
+    if(isNonRealtime() || isSuspended() || isSendingStalled())
+    {
+        return false;
+    }
+    m_state_captured.reset();
+    m_state_requested.store(true);
+    if(!m_state_captured.wait(state_timeout))
+    {
+        // If the request is still pending, the audio thread is not processing and
+        // the request is canceled, otherwise the capture is already in progress.
+        if(m_state_requested.exchange(false))
+        {
+            return false;
+        }
+        m_state_captured.wait(-1);
+    }
+    return !m_state.overflow;
+}
+
+void CamomileAudioProcessor::captureLists(std::vector<std::vector<pd::Atom>>& lists)
+{
+    // The state is captured at a tick boundary by the audio thread in preallocated
+    // memory, the processing is only suspended if the audio thread can't do it.
+    const ScopedLock lock(m_state_lock);
+    if(!captureStateAsync())
+    {
+        suspendProcessing(true);
+        captureState(true);
+        suspendProcessing(false);
+    }
+    
+    lists.clear();
+    lists.resize(m_state.sizes.size());
+    size_t index = 0;
+    for(size_t i = 0; i < lists.size(); ++i)
+    {
+        auto& list = lists[i];
+        list.reserve(m_state.sizes[i]);
+        for(size_t j = 0; j < m_state.sizes[i]; ++j, ++index)
+        {
+            auto const& atom = m_state.atoms[index];
+            if(atom.symbol < 0) {
+                list.push_back(atom.value); }
+            else {
+                list.push_back(std::string(m_state.text.data() + atom.symbol)); }
+        }
+    }
+}
+
+void CamomileAudioProcessor::getStateInformation(MemoryBlock& destData)
+{
+    std::vector<std::vector<pd::Atom>> lists;
+    captureLists(lists);
+    auto const& parameters = getParameters();
+    std::vector<float> params(static_cast<size_t>(parameters.size()));
+    for(int i = 0; i < parameters.size(); ++i)
+    {
+        params[static_cast<size_t>(i)] = parameters[i]->getValue();
+    }
+    destData.reset();
+    MemoryOutputStream stream(destData, false);
+    CamomileStateHelper::write(stream, params, m_console_bounds, lists);
+}
+
+void CamomileAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
+{
+    std::vector<std::vector<pd::Atom>> lists;
+    std::vector<float> params;
+    Rectangle<int> bounds;
+    if(sizeInBytes > 0 && CamomileStateHelper::read(data, static_cast<size_t>(sizeInBytes), params, bounds, lists))
+    {
+        if(CamomileEnvironment::wantsAutoProgram())
+        {
+            auto const& parameters = getParameters();
+            for(int i = 0; i < parameters.size() && static_cast<size_t>(i) < params.size(); ++i)
+            {
+                parameters[i]->setValueNotifyingHost(params[static_cast<size_t>(i)]);
+            }
+        }
+        m_console_bounds = bounds;
+        loadInformation(lists);
+        return;
+    }
+
+    lists.clear();
+    auto xml(getXmlFromBinary(data, sizeInBytes));
+    if(xml && xml->hasTagName("CamomileSettings"))
+    {
+        if(CamomileEnvironment::wantsAutoProgram())
+        {
+            CamomileAudioParameter::loadStateInformation(*xml, getParameters());
+        }
+        CamomileStateHelper::read(*xml, lists);
+        XmlElement const* cbounds = xml->getChildByName(juce::StringRef("console"));
+        if(cbounds)
+        {
+            m_console_bounds.setX(cbounds->getIntAttribute(String("x")));
+            m_console_bounds.setY(cbounds->getIntAttribute(String("y")));
+            m_console_bounds.setWidth(cbounds->getIntAttribute(String("width")));
+            m_console_bounds.setHeight(cbounds->getIntAttribute(String("height")));
+        }
+    }
+    loadInformation(lists);
+}
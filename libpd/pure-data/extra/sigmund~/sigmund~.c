@@ -1540,7 +1540,7 @@ static void sigmund_list(t_sigmund *x, t_symbol *s, int argc, t_atom *argv)
     bufsize = sizeof(t_float)*npts;
     arraypoints = (t_float *)getbytes(bufsize);
     if (!(a = (t_garray *)pd_findbyclass(syminput, garray_class)) ||
-        !garray_getfloatwords(a, &arraysize, &wordarray) ||
+        !garray_readfloatwords(a, &arraysize, &wordarray) || /* camomile */
             arraysize < onset + npts)
     {
         pd_error(0, "sigmund~: '%s' array missing or too small", syminput->s_name);
@@ -21,6 +21,9 @@ typedef struct _tabwrite_tilde
     t_word *x_vec;
     t_symbol *x_arrayname;
     t_float x_f;
+    /* camomile { */
+    t_garray *x_garray;
+    /* } camomile */
 } t_tabwrite_tilde;
 
 static void tabwrite_tilde_tick(t_tabwrite_tilde *x);
@@ -39,7 +42,10 @@ static void tabwrite_tilde_redraw(t_tabwrite_tilde *x)
     t_garray *a = (t_garray *)pd_findbyclass(x->x_arrayname, garray_class);
     if (!a)
         bug("tabwrite_tilde_redraw");
-    else garray_redraw(a);
+    /* camomile { */
+        /* the modified range is already marked by the perform routine */
+    else garray_redrawrange(a, 0, 0);
+    /* } camomile */
 }
 
 static t_int *tabwrite_tilde_perform(t_int *w)
@@ -62,6 +68,9 @@ static t_int *tabwrite_tilde_perform(t_int *w)
                 f = 0;
             (wp++)->w_float = f;
         }
+        /* camomile { */
+        garray_touchrange(x->x_garray, x->x_phase, phase);
+        /* } camomile */
         if (phase >= endphase)
         {
             tabwrite_tilde_redraw(x);
@@ -91,6 +100,9 @@ static void tabwrite_tilde_set(t_tabwrite_tilde *x, t_symbol *s)
         x->x_vec = 0;
     }
     else garray_usedindsp(a);
+    /* camomile { */
+    x->x_garray = a;
+    /* } camomile */
 }
 
 static void tabwrite_tilde_dsp(t_tabwrite_tilde *x, t_signal **sp)
@@ -210,7 +222,9 @@ static void tabplay_tilde_set(t_tabplay_tilde *x, t_symbol *s)
             x->x_arrayname->s_name);
         x->x_vec = 0;
     }
-    else if (!garray_getfloatwords(a, &x->x_nsampsintab, &x->x_vec))
+    /* camomile { */
+    else if (!garray_readfloatwords(a, &x->x_nsampsintab, &x->x_vec))
+    /* } camomile */
     {
         pd_error(x, "%s: bad template for tabplay~", x->x_arrayname->s_name);
         x->x_vec = 0;
@@ -330,7 +344,9 @@ static void tabread_tilde_set(t_tabread_tilde *x, t_symbol *s)
             pd_error(x, "tabread~: %s: no such array", x->x_arrayname->s_name);
         x->x_vec = 0;
     }
-    else if (!garray_getfloatwords(a, &x->x_npoints, &x->x_vec))
+    /* camomile { */
+    else if (!garray_readfloatwords(a, &x->x_npoints, &x->x_vec))
+    /* } camomile */
     {
         pd_error(x, "%s: bad template for tabread~", x->x_arrayname->s_name);
         x->x_vec = 0;
@@ -461,7 +477,9 @@ static void tabread4_tilde_set(t_tabread4_tilde *x, t_symbol *s)
             pd_error(x, "tabread4~: %s: no such array", x->x_arrayname->s_name);
         x->x_vec = 0;
     }
-    else if (!garray_getfloatwords(a, &x->x_npoints, &x->x_vec))
+    /* camomile { */
+    else if (!garray_readfloatwords(a, &x->x_npoints, &x->x_vec))
+    /* } camomile */
     {
         pd_error(x, "%s: bad template for tabread4~", x->x_arrayname->s_name);
         x->x_vec = 0;
@@ -628,7 +646,9 @@ static void tabosc4_tilde_set(t_tabosc4_tilde *x, t_symbol *s)
             pd_error(x, "tabosc4~: %s: no such array", x->x_arrayname->s_name);
         x->x_vec = 0;
     }
-    else if (!garray_getfloatwords(a, &pointsinarray, &x->x_vec))
+    /* camomile { */
+    else if (!garray_readfloatwords(a, &pointsinarray, &x->x_vec))
+    /* } camomile */
     {
         pd_error(x, "%s: bad template for tabosc4~", x->x_arrayname->s_name);
         x->x_vec = 0;
@@ -819,7 +839,9 @@ static void tabreceive_set(t_tabreceive *x, t_symbol *s)
                 x->x_arrayname->s_name);
         x->x_vec = 0;
     }
-    else if (!garray_getfloatwords(a, &x->x_npoints, &x->x_vec))
+    /* camomile { */
+    else if (!garray_readfloatwords(a, &x->x_npoints, &x->x_vec))
+    /* } camomile */
     {
         pd_error(x, "%s: bad template for tabreceive~",
             x->x_arrayname->s_name);
@@ -872,7 +894,9 @@ static void tabread_float(t_tabread *x, t_float f)
 
     if (!(a = (t_garray *)pd_findbyclass(x->x_arrayname, garray_class)))
         pd_error(x, "%s: no such array", x->x_arrayname->s_name);
-    else if (!garray_getfloatwords(a, &npoints, &vec))
+    /* camomile { */
+    else if (!garray_readfloatwords(a, &npoints, &vec))
+    /* } camomile */
         pd_error(x, "%s: bad template for tabread", x->x_arrayname->s_name);
     else
     {
@@ -923,7 +947,9 @@ static void tabread4_float(t_tabread4 *x, t_float f)
 
     if (!(a = (t_garray *)pd_findbyclass(x->x_arrayname, garray_class)))
         pd_error(x, "%s: no such array", x->x_arrayname->s_name);
-    else if (!garray_getfloatwords(a, &npoints, &vec))
+    /* camomile { */
+    else if (!garray_readfloatwords(a, &npoints, &vec))
+    /* } camomile */
         pd_error(x, "%s: bad template for tabread4", x->x_arrayname->s_name);
     else if (npoints < 4)
         outlet_float(x->x_obj.ob_outlet, 0);
@@ -1002,7 +1028,7 @@ static void tabwrite_float(t_tabwrite *x, t_float f)
         else if (n >= vecsize)
             n = vecsize-1;
         vec[n].w_float = f;
-        garray_redraw(a);
+        garray_redrawrange(a, n, n + 1);
     }
 }
 
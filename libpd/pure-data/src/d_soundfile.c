@@ -1114,6 +1114,47 @@ done:
            -ascii
     */
 
+/* camomile { */
+    /* the tables resized to the sound file read are shared by all the
+    instances of the process (see garray_getshared()).  The file is found by
+    its device, inode, size and modification time, with the format and the
+    part of the file read.  Returns 0 if the file can't be identified. */
+#ifndef _WIN32
+#include <sys/stat.h>
+#endif
+
+static int soundfiler_sharekey(int fd, const t_soundfile *sf,
+    size_t skipframes, ssize_t framesinfile, long *key)
+{
+#ifdef _WIN32
+    return (0);
+#else
+    struct stat st;
+    if (fstat(fd, &st) < 0)
+        return (0);
+    key[0] = (long)st.st_dev;
+    key[1] = (long)st.st_ino;
+    key[2] = (long)st.st_size;
+    key[3] = (long)st.st_mtime;
+#if defined(__APPLE__)
+    key[4] = (long)st.st_mtimespec.tv_nsec;
+#elif defined(__linux__)
+    key[4] = (long)st.st_mtim.tv_nsec;
+#else
+    key[4] = 0;
+#endif
+    key[5] = (long)skipframes;
+    key[6] = (long)framesinfile;
+    key[7] = (long)sf->sf_headersize;
+    key[8] = (long)sf->sf_nchannels;
+    key[9] = (long)sf->sf_bytespersample;
+    key[10] = (long)sf->sf_bigendian;
+    key[11] = (long)sf->sf_bytelimit;
+    return (1);
+#endif
+}
+/* } camomile */
+
 static void soundfiler_read(t_soundfiler *x, t_symbol *s,
     int argc, t_atom *argv)
 {
@@ -1127,6 +1168,8 @@ static void soundfiler_read(t_soundfiler *x, t_symbol *s,
     t_garray *garrays[MAXSFCHANS];
     t_word *vecs[MAXSFCHANS];
     char sampbuf[SAMPBUFSIZE];
+    long sharekey[GARRAY_SHAREKEY]; /* camomile */
+    int share = 0;                  /* camomile */
 
     soundfile_clear(&sf);
     sf.sf_headersize = -1;
@@ -1233,8 +1276,10 @@ static void soundfiler_read(t_soundfiler *x, t_symbol *s,
                 argv[i].a_w.w_symbol->s_name);
             goto done;
         }
-        else if (!garray_getfloatwords(garrays[i], &vecsize,
-                &vecs[i]))
+            /* camomile: the vectors are fetched again after resizing */
+        else if (!(resize ?
+            garray_readfloatwords(garrays[i], &vecsize, &vecs[i]) :
+            garray_getfloatwords(garrays[i], &vecsize, &vecs[i])))
             pd_error(x, "soundfiler read: %s: bad template for tabwrite",
                 argv[i].a_w.w_symbol->s_name);
         if (finalsize && finalsize != (size_t)vecsize && !resize)
@@ -1283,9 +1328,24 @@ static void soundfiler_read(t_soundfiler *x, t_symbol *s,
             framesinfile = maxsize;
         }
         finalsize = framesinfile;
+        /* camomile { */
+        share = (argc > 0 && argc <= sf.sf_nchannels &&
+            soundfiler_sharekey(fd, &sf, skipframes, framesinfile, sharekey));
+        if (share && garray_getshared(argc, garrays, sharekey))
+        {
+            for (i = 0; i < argc; i++)
+            {
+                garray_setsaveit(garrays[i], 0);
+                garray_redraw(garrays[i]);
+            }
+            framesread = finalsize;
+            goto done;
+        }
+        /* } camomile */
         for (i = 0; i < argc; i++)
         {
             int vecsize;
+            garray_dropshared(garrays[i]); /* camomile */
             garray_resize_long(garrays[i], finalsize);
                 /* for sanity's sake let's clear the save-in-patch flag here */
             garray_setsaveit(garrays[i], 0);
@@ -1346,6 +1406,10 @@ static void soundfiler_read(t_soundfiler *x, t_symbol *s,
         /* do all graphics updates */
     for (i = 0; i < argc; i++)
         garray_redraw(garrays[i]);
+    /* camomile { */
+    if (share && framesread == finalsize)
+        garray_putshared(argc, garrays, sharekey);
+    /* } camomile */
     goto done;
 usage:
     pd_error(x, "usage: read [flags] filename [tablename]...");
@@ -1426,7 +1490,9 @@ size_t soundfiler_dowrite(void *obj, t_canvas *canvas,
                 argv[i].a_w.w_symbol->s_name);
             goto fail;
         }
-        else if (!garray_getfloatwords(garrays[i], &vecsize, &vectors[i]))
+        /* camomile { */
+        else if (!garray_readfloatwords(garrays[i], &vecsize, &vectors[i]))
+        /* } camomile */
             pd_error(obj, "soundfiler write: %s: bad template for tabwrite",
                 argv[i].a_w.w_symbol->s_name);
         if (wa.wa_nframes > vecsize - wa.wa_onsetframes)
@@ -8,6 +8,20 @@
 #include "m_pd.h"
 #include "g_canvas.h"
 #include <math.h>
+/* camomile { */
+#include <limits.h>
+/* } camomile */
+
+/* camomile { */
+#define GARRAY_NCHANGES 8   /* number of modified ranges kept per array */
+
+typedef struct _garraychange
+{
+    unsigned int c_version;         /* last version merged in the range */
+    int c_from;
+    int c_to;
+} t_garraychange;
+/* } camomile */
 
 /* jsarlo { */
 #define ARRAYPAGESIZE 1000  /* this should match the page size in u_main.tk */
@@ -41,6 +55,9 @@ t_array *array_new(t_symbol *templatesym, t_gpointer *parent)
 /* jsarlo { */
 void garray_arrayviewlist_close(t_garray *x);
 /* } jsarlo */
+/* camomile { */
+static void array_retireshared(t_array *x, char *vec);
+/* } camomile */
 
 void array_resize(t_array *x, int n)
 {
@@ -52,6 +69,17 @@ void array_resize(t_array *x, int n)
     oldn = x->a_n;
     elemsize = sizeof(t_word) * template->t_n;
 
+    /* camomile { */
+    if (x->a_shared)
+    {
+            /* only the elements kept are copied from the shared vector */
+        if (!(tmp = (char *)getbytes(n * elemsize)))
+            return;
+        memcpy(tmp, x->a_vec, (n < oldn ? n : oldn) * elemsize);
+        array_retireshared(x, tmp);
+    }
+    else
+    /* } camomile */
     tmp = (char *)resizebytes(x->a_vec, oldn * elemsize, n * elemsize);
     if (!tmp)
         return;
@@ -83,6 +111,113 @@ void array_resize_and_redraw(t_array *array, t_glist *glist, int n)
         gobj_vis(&a2->a_gp.gp_un.gp_scalar->sc_gobj, glist, 1);
 }
 
+/* camomile { */
+    /* the vectors of the arrays read from the same sound files by
+    "soundfiler read -resize" are shared by all the instances of the process
+    (see garray_getshared() below).  An array that shares a vector copies it
+    before it is modified, and the shared vector is released once the DSP
+    chain, that may still point to it, is rebuilt. */
+#ifdef PDTHREADS
+#include "pthread.h"
+#endif
+
+#define GARRAY_SHAREMAX 64  /* channels shared at once, as MAXSFCHANS */
+
+typedef struct _tableshare
+{
+    long s_key[GARRAY_SHAREKEY];    /* file and format read */
+    int s_channel;
+    int s_n;
+    int s_elemsize;
+    char *s_vec;
+    int s_refcount;                 /* number of arrays using the vector */
+    struct _tableshare *s_next;
+} t_tableshare;
+
+typedef struct _tableretired
+{
+    t_tableshare *r_share;
+    struct _tableretired *r_next;
+} t_tableretired;
+
+static t_tableshare *array_sharelist;
+#ifdef PDTHREADS
+static pthread_mutex_t array_sharemutex = PTHREAD_MUTEX_INITIALIZER;
+#define array_sharelock() pthread_mutex_lock(&array_sharemutex)
+#define array_shareunlock() pthread_mutex_unlock(&array_sharemutex)
+#else
+#define array_sharelock()
+#define array_shareunlock()
+#endif
+
+static void array_sharerelease(t_tableshare *s)
+{
+    t_tableshare **sp;
+    array_sharelock();
+    if (--s->s_refcount)
+        s = 0;
+    else
+    {
+        for (sp = &array_sharelist; *sp != s; sp = &(*sp)->s_next)
+            ;
+        *sp = s->s_next;
+    }
+    array_shareunlock();
+    if (s)
+    {
+        freebytes(s->s_vec, s->s_n * s->s_elemsize);
+        freebytes(s, sizeof(*s));
+    }
+}
+
+static void array_releaseretired(t_array *x)
+{
+    while (x->a_retired)
+    {
+        t_tableretired *r = x->a_retired;
+        x->a_retired = r->r_next;
+        array_sharerelease(r->r_share);
+        freebytes(r, sizeof(*r));
+    }
+}
+
+    /* called from the scheduler once the modification is done */
+static void array_retiretick(t_array *x)
+{
+    canvas_update_dsp();
+    array_releaseretired(x);
+}
+
+    /* replace the shared vector of the array by its own vector */
+static void array_retireshared(t_array *x, char *vec)
+{
+    t_tableretired *r = (t_tableretired *)getbytes(sizeof(*r));
+    r->r_share = x->a_shared;
+    r->r_next = x->a_retired;
+    x->a_retired = r;
+    x->a_shared = 0;
+    x->a_vec = vec;
+    x->a_valid = ++glist_valid;
+    if (!x->a_clock)
+        x->a_clock = clock_new(x, (t_method)array_retiretick);
+    clock_delay(x->a_clock, 0);
+}
+
+    /* give the array its own copy of the shared vector before writing it.
+    It is called by the scheduler, so the first modification of a shared
+    vector allocates and copies it within the tick. */
+void array_unshare(t_array *x)
+{
+    char *vec;
+    if (!x->a_shared)
+        return;
+    if (!(vec = (char *)getbytes(x->a_n * x->a_elemsize)))
+        return;
+    memcpy(vec, x->a_vec, x->a_n * x->a_elemsize);
+    array_retireshared(x, vec);
+}
+/* } camomile */
+
 void word_free(t_word *wp, t_template *template);
 
 void array_free(t_array *x)
@@ -95,7 +230,17 @@ void array_free(t_array *x)
         t_word *wp = (t_word *)(x->a_vec + x->a_elemsize * i);
         word_free(wp, scalartemplate);
     }
+    /* camomile { */
+    if (x->a_shared)
+        array_sharerelease(x->a_shared);
+    else
+    /* } camomile */
     freebytes(x->a_vec, x->a_elemsize * x->a_n);
+    /* camomile { */
+    array_releaseretired(x);
+    if (x->a_clock)
+        clock_free(x->a_clock);
+    /* } camomile */
     freebytes(x, sizeof *x);
 }
 
@@ -116,6 +261,13 @@ struct _garray
     unsigned int  x_listviewing:1;  /* list view window is open */
     unsigned int  x_hidename:1;     /* don't print name above graph */
     unsigned int  x_edit:1;         /* we can edit the array */
+    /* camomile { */
+    unsigned int x_version;         /* incremented at each modification */
+    unsigned int x_evicted;         /* last version of the evicted ranges */
+    unsigned int x_changesread:1;   /* the last range was read by a client */
+    int x_nchanges;                 /* ranges modified, oldest first */
+    t_garraychange x_changes[GARRAY_NCHANGES];
+    /* } camomile */
 };
 
 static t_pd *garray_arraytemplatecanvas;  /* written at setup w/ global lock */
@@ -584,6 +736,17 @@ void array_redraw(t_array *a, t_glist *glist)
 {
     while (a->a_gp.gp_stub->gs_which == GP_ARRAY)
         a = a->a_gp.gp_stub->gs_un.gs_array;
+    /* camomile { */
+        /* the array of a garray is modified by [array set] */
+    if (glist)
+    {
+        t_gobj *g;
+        for (g = glist->gl_list; g; g = g->g_next)
+            if (pd_class(&g->g_pd) == garray_class &&
+                ((t_garray *)g)->x_scalar == a->a_gp.gp_un.gp_scalar)
+                    garray_touchrange((t_garray *)g, 0, INT_MAX);
+    }
+    /* } camomile */
     scalar_redraw(a->a_gp.gp_un.gp_scalar, glist);
 }
 
@@ -791,7 +954,87 @@ static void garray_doredraw(t_gobj *client, t_glist *glist)
     }
 }
 
+/* camomile { */
+    /* the modifications are tracked so that the clients without GUI can
+    fetch only the range of the array that changed since they last read
+    it.  The ranges are merged until a client reads them, and the oldest
+    ones are evicted when there are too many of them. */
+void garray_touchrange(t_garray *x, int from, int to)
+{
+    t_garraychange *change;
+    if (from >= to)
+        return;
+    x->x_version++;
+    if (x->x_nchanges && !x->x_changesread)
+    {
+        change = &x->x_changes[x->x_nchanges - 1];
+        if (from < change->c_from)
+            change->c_from = from;
+        if (to > change->c_to)
+            change->c_to = to;
+        change->c_version = x->x_version;
+        return;
+    }
+    if (x->x_nchanges == GARRAY_NCHANGES)
+    {
+        x->x_evicted = x->x_changes[0].c_version;
+        memmove(x->x_changes, x->x_changes + 1,
+            (GARRAY_NCHANGES - 1) * sizeof(*x->x_changes));
+        x->x_nchanges--;
+    }
+    change = &x->x_changes[x->x_nchanges++];
+    change->c_version = x->x_version;
+    change->c_from = from;
+    change->c_to = to;
+    x->x_changesread = 0;
+}
+
+    /* get the current version of the array and the range [from, to)
+    modified since the version "since" seen by the client.  If the ranges
+    of that version were evicted, the whole array is reported.  The range
+    is not clipped to the size of the array. */
+unsigned int garray_getchanges(t_garray *x, unsigned int since,
+    int *from, int *to)
+{
+    int i;
+    *from = *to = 0;
+    if ((int)(since - x->x_evicted) < 0 || (int)(since - x->x_version) > 0)
+        *to = INT_MAX;
+    else for (i = 0; i < x->x_nchanges; i++)
+    {
+        t_garraychange *change = &x->x_changes[i];
+        if ((int)(change->c_version - since) <= 0)
+            continue;
+        if (*from >= *to)
+            *from = change->c_from, *to = change->c_to;
+        else
+        {
+            if (change->c_from < *from)
+                *from = change->c_from;
+            if (change->c_to > *to)
+                *to = change->c_to;
+        }
+    }
+    x->x_changesread = 1;
+    return (x->x_version);
+}
+
+static void garray_queueredraw(t_garray *x);
+
+void garray_redrawrange(t_garray *x, int from, int to)
+{
+    garray_touchrange(x, from, to);
+    garray_queueredraw(x);
+}
+
 void garray_redraw(t_garray *x)
+{
+    garray_touchrange(x, 0, INT_MAX);
+    garray_queueredraw(x);
+}
+/* } camomile */
+
+static void garray_queueredraw(t_garray *x)
 {
     if (glist_isvisible(x->x_glist))
         sys_queuegui(&x->x_gobj, x->x_glist, garray_doredraw);
@@ -826,6 +1069,8 @@ int garray_npoints(t_garray *x) /* get the length */
     return (array->a_n);
 }
 
+    /* camomile: a shared vector is returned without copy, like
+    garray_readfloatwords() does; the writers use garray_getfloatwords() */
 char *garray_vec(t_garray *x) /* get the contents */
 {
     t_array *array = garray_getarray(x);
@@ -849,6 +1094,7 @@ int garray_getfloatwords(t_garray *x, int *size, t_word **vec)
         pd_error(0, "%s: has more than one field", x->x_realname->s_name);
         return (0);
     }
+    array_unshare(a); /* camomile */
     *size = garray_npoints(x);
     *vec =  (t_word *)garray_vec(x);
     return (1);
@@ -871,6 +1117,29 @@ int garray_getfloatarray(t_garray *x, int *size, t_float **vec)
     return (garray_getfloatwords(x, size, (t_word **)vec));
 }
 
+/* camomile { */
+    /* same as garray_getfloatwords() for the routines that only read the
+    array, the vector is not copied if it is shared (see array_unshare()) */
+int garray_readfloatwords(t_garray *x, int *size, t_word **vec)
+{
+    int yonset, elemsize;
+    t_array *a = garray_getarray_floatonly(x, &yonset, &elemsize);
+    if (!a)
+    {
+        pd_error(0, "%s: needs floating-point 'y' field", x->x_realname->s_name);
+        return (0);
+    }
+    else if (elemsize != sizeof(t_word))
+    {
+        pd_error(0, "%s: has more than one field", x->x_realname->s_name);
+        return (0);
+    }
+    *size = a->a_n;
+    *vec = (t_word *)a->a_vec;
+    return (1);
+}
+/* } camomile */
+
     /* set the "saveit" flag */
 void garray_setsaveit(t_garray *x, int saveit)
 {
@@ -887,9 +1156,13 @@ static void garray_const(t_garray *x, t_floatarg g)
     t_array *array = garray_getarray_floatonly(x, &yonset, &elemsize);
     if (!array)
         pd_error(0, "%s: needs floating-point 'y' field", x->x_realname->s_name);
-    else for (i = 0; i < array->a_n; i++)
-        *((t_float *)((char *)array->a_vec
-            + elemsize * i) + yonset) = g;
+    else
+    {
+        array_unshare(array); /* camomile */
+        for (i = 0; i < array->a_n; i++)
+            *((t_float *)((char *)array->a_vec
+                + elemsize * i) + yonset) = g;
+    }
     garray_redraw(x);
 }
 
@@ -911,6 +1184,7 @@ static void garray_dofo(t_garray *x, long npoints, t_float dcval,
         post("%s: rounding to %d points", array->a_templatesym->s_name,
             (npoints = (1<<ilog2((int)npoints))));
     garray_resize_long(x, npoints + 3);
+    array_unshare(array); /* camomile */
     phaseincr = 2. * 3.14159 / npoints;
     for (i = 0, phase = -phaseincr; i < array->a_n; i++, phase += phaseincr)
     {
@@ -986,6 +1260,7 @@ static void garray_normalize(t_garray *x, t_float f)
         pd_error(0, "%s: needs floating-point 'y' field", x->x_realname->s_name);
         return;
     }
+    array_unshare(array); /* camomile */
 
     if (f <= 0)
         f = 1;
@@ -1040,11 +1315,12 @@ static void garray_list(t_garray *x, t_symbol *s, int argc, t_atom *argv)
             argc = array->a_n - firstindex;
             if (argc <= 0) return;
         }
+        array_unshare(array); /* camomile */
         for (i = 0; i < argc; i++)
             *((t_float *)(array->a_vec + elemsize * (i + firstindex)) + yonset)
                 = atom_getfloat(argv + i);
+        garray_redrawrange(x, firstindex, firstindex + argc);
     }
-    garray_redraw(x);
 }
 
     /* forward a "bounds" message to the owning graph */
@@ -1204,6 +1480,7 @@ static void garray_read(t_garray *x, t_symbol *filename)
         pd_error(0, "%s: can't open", filename->s_name);
         return;
     }
+    array_unshare(array); /* camomile */
     for (i = 0; i < nelem; i++)
     {
         double f;
@@ -1267,6 +1544,128 @@ void garray_resize_long(t_garray *x, long n)
         canvas_update_dsp();
 }
 
+/* camomile { */
+    /* the shared vectors are only used by the arrays of floats */
+static t_array *garray_getsharable(t_garray *x)
+{
+    int yonset, elemsize;
+    t_array *a = garray_getarray_floatonly(x, &yonset, &elemsize);
+    return (a && elemsize == sizeof(t_word) ? a : 0);
+}
+
+    /* replace the vector of the array by a shared one, as
+    garray_resize_long() does when the size changes */
+static void garray_setshared(t_garray *x, t_array *array, t_tableshare *s)
+{
+    int vis = glist_isvisible(x->x_glist);
+    if (s->s_n != array->a_n)
+        garray_fittograph(x, s->s_n, template_getfloat(
+            template_findbyname(x->x_scalar->sc_template),
+                gensym("style"), x->x_scalar->sc_vec, 1));
+    if (vis)
+        gobj_vis(&x->x_scalar->sc_gobj, x->x_glist, 0);
+    if (array->a_shared)
+        array_sharerelease(array->a_shared);
+    else freebytes(array->a_vec, array->a_elemsize * array->a_n);
+    array->a_shared = s;
+    array->a_vec = s->s_vec;
+    array->a_n = s->s_n;
+    array->a_valid = ++glist_valid;
+    if (vis)
+        gobj_vis(&x->x_scalar->sc_gobj, x->x_glist, 1);
+    if (x->x_usedindsp)
+        canvas_update_dsp();
+}
+
+static t_tableshare *garray_findshared(int channel, const long *key)
+{
+    t_tableshare *s;
+    for (s = array_sharelist; s; s = s->s_next)
+        if (s->s_channel == channel &&
+            !memcmp(s->s_key, key, sizeof(s->s_key)))
+                return (s);
+    return (0);
+}
+
+    /* make the n arrays share the vectors of the channels of a file already
+    read by another array of the process.  The key identifies the file and
+    the format read (see soundfiler_read()).  Returns 0 if one of the
+    channels was not read, the arrays are then not modified. */
+int garray_getshared(int n, t_garray **garrays, const long *key)
+{
+    t_tableshare *shares[GARRAY_SHAREMAX];
+    t_array *arrays[GARRAY_SHAREMAX];
+    int i;
+    if (n > GARRAY_SHAREMAX)
+        return (0);
+    for (i = 0; i < n; i++)
+        if (!(arrays[i] = garray_getsharable(garrays[i])))
+            return (0);
+    array_sharelock();
+    for (i = 0; i < n; i++)
+        if (!(shares[i] = garray_findshared(i, key)))
+            break;
+    if (i == n)
+        for (i = 0; i < n; i++)
+            shares[i]->s_refcount++;
+    array_shareunlock();
+    if (i < n)
+        return (0);
+    for (i = 0; i < n; i++)
+    {
+        if (arrays[i]->a_shared == shares[i])
+            array_sharerelease(shares[i]);
+        else garray_setshared(garrays[i], arrays[i], shares[i]);
+    }
+    return (1);
+}
+
+    /* let the array stop sharing its vector without copying it, before it
+    is resized and overwritten.  The array is left with one element. */
+void garray_dropshared(t_garray *x)
+{
+    t_array *a = garray_getsharable(x);
+    char *vec;
+    if (!a || !a->a_shared || !(vec = (char *)getbytes(a->a_elemsize)))
+        return;
+    array_retireshared(a, vec);
+    a->a_n = 1;
+}
+
+    /* share the vectors of the n arrays just read from a file.  The vectors
+    are given to the shared entries without copy. */
+void garray_putshared(int n, t_garray **garrays, const long *key)
+{
+    t_tableshare *s;
+    t_array *a;
+    int i;
+    for (i = 0; i < n && i < GARRAY_SHAREMAX; i++)
+    {
+        if (!(a = garray_getsharable(garrays[i])) || a->a_shared)
+            continue;
+        s = (t_tableshare *)getbytes(sizeof(*s));
+        memcpy(s->s_key, key, sizeof(s->s_key));
+        s->s_channel = i;
+        s->s_n = a->a_n;
+        s->s_elemsize = a->a_elemsize;
+        s->s_vec = a->a_vec;
+        s->s_refcount = 1;
+        array_sharelock();
+        if (garray_findshared(i, key))
+        {
+                /* read at the same time by another instance */
+            array_shareunlock();
+            freebytes(s, sizeof(*s));
+            continue;
+        }
+        s->s_next = array_sharelist;
+        array_sharelist = s;
+        array_shareunlock();
+        a->a_shared = s;
+    }
+}
+/* } camomile */
+
     /* float version to use as Pd method */
 void garray_resize(t_garray *x, t_floatarg f)
 {
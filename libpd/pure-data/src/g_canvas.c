@@ -1846,6 +1846,24 @@ static int canvas_open_iter(const char *path, t_canvasopen *co)
     attempted, otherwise ASCII (this only matters on Microsoft.)
     If "x" is zero, the file is sought in the directory "." or in the
     global path.*/
+/* camomile { */
+static t_canvasopenhook canvas_openhook;
+
+    /* set a function called with the directory and the name of the files
+    opened by canvas_open(), it can be called by any thread. */
+void canvas_setopenhook(t_canvasopenhook hook)
+{
+    canvas_openhook = hook;
+}
+
+static int canvas_opened(int fd, const char *dirresult, char **nameresult)
+{
+    if (fd >= 0 && canvas_openhook)
+        canvas_openhook(dirresult, *nameresult);
+    return (fd);
+}
+/* } camomile */
+
 int canvas_open(const t_canvas *x, const char *name, const char *ext,
     char *dirresult, char **nameresult, unsigned int size, int bin)
 {
@@ -1854,7 +1872,7 @@ int canvas_open(const t_canvas *x, const char *name, const char *ext,
 
         /* first check if "name" is absolute (and if so, try to open) */
     if (sys_open_absolute(name, ext, dirresult, nameresult, size, bin, &fd))
-        return (fd);
+        return (canvas_opened(fd, dirresult, nameresult)); /* camomile */
 
         /* otherwise "name" is relative; iterate over all the search-paths */
     co.name = name;
@@ -1867,7 +1885,7 @@ int canvas_open(const t_canvas *x, const char *name, const char *ext,
 
     canvas_path_iterate(x, (t_canvas_path_iterator)canvas_open_iter, &co);
 
-    return (co.fd);
+    return (canvas_opened(co.fd, dirresult, nameresult)); /* camomile */
 }
 
 /*
@@ -243,6 +243,11 @@ struct _array
     int a_valid;        /* protection against stale pointers into array */
     t_gpointer a_gp;    /* pointer to scalar or array element we're in */
     t_gstub *a_stub;    /* stub for pointing into this array */
+/* camomile { */
+    struct _tableshare *a_shared;   /* vector shared with other instances */
+    struct _tableretired *a_retired;    /* shared vectors no longer used */
+    t_clock *a_clock;   /* releases the retired vectors */
+/* } camomile */
 };
 
     /* structure for traversing all the connections in a glist */
@@ -576,6 +581,9 @@ EXTERN void array_resize(t_array *x, int n);
 EXTERN void array_free(t_array *x);
 EXTERN void array_redraw(t_array *a, t_glist *glist);
 EXTERN void array_resize_and_redraw(t_array *array, t_glist *glist, int n);
+/* camomile { */
+EXTERN void array_unshare(t_array *x);
+/* } camomile */
 
 /* --------------------- gpointers and stubs ---------------- */
 EXTERN t_gstub *gstub_new(t_glist *gl, t_array *a);
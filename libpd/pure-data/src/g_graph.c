@@ -10,6 +10,9 @@ to this file... */
 #include "m_pd.h"
 
 #include "g_canvas.h"
+/* camomile { */
+#include "s_stuff.h"
+/* } camomile */
 #include <stdio.h>
 #include <string.h>
 
@@ -75,6 +78,10 @@ void glist_delete(t_glist *x, t_gobj *y)
     int drawcommand = class_isdrawcommand(y->g_pd);
     int wasdeleting;
 
+    /* camomile { */
+    STUFF->st_deletions++;
+    /* } camomile */
+
     if (pd_class(&y->g_pd) == canvas_class) {
             /* JMZ: send a closebang to the canvas */
         canvas_closebang((t_canvas *)y);
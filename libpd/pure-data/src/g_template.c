@@ -397,8 +397,10 @@ static void template_conformarray(t_template *tfrom, t_template *tto,
         /* the array elements must all be conformed */
         int oldelemsize = sizeof(t_word) * tfrom->t_n,
             newelemsize = sizeof(t_word) * tto->t_n;
-        char *newarray = getbytes(newelemsize * a->a_n);
-        char *oldarray = a->a_vec;
+        char *newarray, *oldarray;
+        array_unshare(a); /* camomile */
+        newarray = getbytes(newelemsize * a->a_n);
+        oldarray = a->a_vec;
         if (a->a_elemsize != oldelemsize)
             bug("template_conformarray");
         for (i = 0; i < a->a_n; i++)
@@ -2188,6 +2190,11 @@ static int array_doclick(t_array *array, t_glist *glist, t_scalar *sc,
     t_template *elemtemplate;
     int elemsize, yonset, wonset, xonset, i;
 
+    /* camomile { */
+        /* the array is copied before the mouse modifies it */
+    if (doit)
+        array_unshare(array);
+    /* } camomile */
     if (!array_getfields(elemtemplatesym, &elemtemplatecanvas,
         &elemtemplate, &elemsize, xfield, yfield, wfield,
         &xonset, &yonset, &wonset))
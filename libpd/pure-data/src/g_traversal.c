@@ -756,6 +756,7 @@ static void elem_float(t_elem *x, t_float f)
     elemsize = elemtemplate->t_n * sizeof(t_word);
 
     array = *(t_array **)(((char *)w) + onset);
+    array_unshare(array); /* camomile: the element can be set */
 
     nitems = array->a_n;
     if (indx < 0) indx = 0;
@@ -959,6 +960,7 @@ static void setsize_float(t_setsize *x, t_float f)
     nitems = array->a_n;
     if (newsize < 1) newsize = 1;
     if (newsize == nitems) return;
+    array_unshare(array); /* camomile */
 
         /* erase the array before resizing it.  If we belong to a
         scalar it's easy, but if we belong to an element of another
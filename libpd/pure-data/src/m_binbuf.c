@@ -813,6 +813,190 @@ broken:
          ATOMS_FREEA(mstack, maxnargs);
 }
 
+/* camomile { */
+    /* the atoms of the files read by binbuf_read() are shared by all the
+    instances of the process, so the instances that open the same patches and
+    abstractions don't read and tokenize them again.  The symbols are kept by
+    name, since each instance has its own symbol table, and are interned again
+    when the atoms are copied to the binbuf.  An entry is found by the path,
+    the size and the modification time of the file, so a file that is saved
+    again is read again. */
+#include <sys/stat.h>
+#ifdef PDTHREADS
+#include "pthread.h"
+#endif
+
+#define BINBUF_CACHESIZE (16 * 1024 * 1024)
+
+typedef struct _binbufcache
+{
+    char *c_path;
+    int c_crflag;
+    long c_size;
+    long c_mtime;
+    long c_mtimens;
+    int c_n;
+    t_atom *c_vec;          /* symbols are offsets in c_names (w_index) */
+    char *c_names;
+    size_t c_namesize;
+    struct _binbufcache *c_next;
+} t_binbufcache;
+
+static t_binbufcache *binbuf_cachelist;
+static size_t binbuf_cachebytes;
+#ifdef PDTHREADS
+static pthread_mutex_t binbuf_cachemutex = PTHREAD_MUTEX_INITIALIZER;
+#define binbuf_cachelock() pthread_mutex_lock(&binbuf_cachemutex)
+#define binbuf_cacheunlock() pthread_mutex_unlock(&binbuf_cachemutex)
+#else
+#define binbuf_cachelock()
+#define binbuf_cacheunlock()
+#endif
+
+static int binbuf_cacheissymbol(const t_atom *ap)
+{
+    return (ap->a_type == A_SYMBOL || ap->a_type == A_DOLLSYM);
+}
+
+static size_t binbuf_cachegetbytes(const t_binbufcache *c)
+{
+    return (strlen(c->c_path) + 1 + c->c_n * sizeof(t_atom) + c->c_namesize);
+}
+
+static void binbuf_cachefree(t_binbufcache *c)
+{
+    binbuf_cachebytes -= binbuf_cachegetbytes(c);
+    freebytes(c->c_path, strlen(c->c_path) + 1);
+    freebytes(c->c_vec, c->c_n * sizeof(t_atom));
+    freebytes(c->c_names, c->c_namesize);
+    freebytes(c, sizeof(*c));
+}
+
+static void binbuf_cachestat(int fd, t_binbufcache *key)
+{
+    struct stat st;
+    key->c_size = -1;
+    if (fstat(fd, &st) < 0)
+        return;
+    key->c_size = (long)st.st_size;
+    key->c_mtime = (long)st.st_mtime;
+#if defined(__APPLE__)
+    key->c_mtimens = (long)st.st_mtimespec.tv_nsec;
+#elif defined(__linux__)
+    key->c_mtimens = (long)st.st_mtim.tv_nsec;
+#else
+    key->c_mtimens = 0;
+#endif
+}
+
+static int binbuf_cachematch(const t_binbufcache *c, const char *path,
+    const t_binbufcache *key)
+{
+    return (c->c_crflag == key->c_crflag && c->c_size == key->c_size &&
+        c->c_mtime == key->c_mtime && c->c_mtimens == key->c_mtimens &&
+            !strcmp(c->c_path, path));
+}
+
+    /* copy the atoms of a cached file to the binbuf, returns 0 on success */
+static int binbuf_cacheget(t_binbuf *b, const char *path,
+    const t_binbufcache *key)
+{
+    t_binbufcache *c, **prev;
+    int i;
+    if (key->c_size < 0)
+        return (1);
+    binbuf_cachelock();
+    for (prev = &binbuf_cachelist; (c = *prev); prev = &c->c_next)
+        if (binbuf_cachematch(c, path, key))
+            break;
+    if (!c)
+    {
+        binbuf_cacheunlock();
+        return (1);
+    }
+        /* the last entry used is moved to the head of the list */
+    *prev = c->c_next;
+    c->c_next = binbuf_cachelist;
+    binbuf_cachelist = c;
+    binbuf_clear(b);
+    if (c->c_n && !binbuf_resize(b, c->c_n))
+    {
+        binbuf_cacheunlock();
+        return (1);
+    }
+    for (i = 0; i < c->c_n; i++)
+    {
+        b->b_vec[i] = c->c_vec[i];
+        if (binbuf_cacheissymbol(&c->c_vec[i]))
+            b->b_vec[i].a_w.w_symbol =
+                gensym(c->c_names + c->c_vec[i].a_w.w_index);
+    }
+    binbuf_cacheunlock();
+    return (0);
+}
+
+    /* add the atoms of a file that has been read to the cache */
+static void binbuf_cacheput(const t_binbuf *b, const char *path,
+    const t_binbufcache *key)
+{
+    t_binbufcache *c, **prev;
+    size_t namesize = 0, onset = 0, len;
+    int i;
+    if (key->c_size < 0)
+        return;
+    for (i = 0; i < b->b_n; i++)
+        if (binbuf_cacheissymbol(&b->b_vec[i]))
+            namesize += strlen(b->b_vec[i].a_w.w_symbol->s_name) + 1;
+    if (strlen(path) + 1 + b->b_n * sizeof(t_atom) + namesize >
+        BINBUF_CACHESIZE)
+            return;
+    c = (t_binbufcache *)getbytes(sizeof(*c));
+    *c = *key;
+    c->c_path = (char *)getbytes(strlen(path) + 1);
+    strcpy(c->c_path, path);
+    c->c_n = b->b_n;
+    c->c_vec = (t_atom *)getbytes(b->b_n * sizeof(t_atom));
+    c->c_namesize = namesize;
+    c->c_names = (char *)getbytes(namesize);
+    for (i = 0; i < b->b_n; i++)
+    {
+        c->c_vec[i] = b->b_vec[i];
+        if (binbuf_cacheissymbol(&b->b_vec[i]))
+        {
+            len = strlen(b->b_vec[i].a_w.w_symbol->s_name) + 1;
+            memcpy(c->c_names + onset, b->b_vec[i].a_w.w_symbol->s_name, len);
+            c->c_vec[i].a_w.w_index = (int)onset;
+            onset += len;
+        }
+    }
+    binbuf_cachelock();
+        /* the previous versions of the file are dropped */
+    for (prev = &binbuf_cachelist; *prev; )
+    {
+        t_binbufcache *old = *prev;
+        if (old->c_crflag == c->c_crflag && !strcmp(old->c_path, path))
+        {
+            *prev = old->c_next;
+            binbuf_cachefree(old);
+        }
+        else prev = &old->c_next;
+    }
+    c->c_next = binbuf_cachelist;
+    binbuf_cachelist = c;
+    binbuf_cachebytes += binbuf_cachegetbytes(c);
+        /* the entries used the least recently are evicted */
+    while (binbuf_cachebytes > BINBUF_CACHESIZE)
+    {
+        for (prev = &binbuf_cachelist; (*prev)->c_next; prev = &(*prev)->c_next)
+            ;
+        c = *prev;
+        *prev = 0;
+        binbuf_cachefree(c);
+    }
+    binbuf_cacheunlock();
+}
+/* } camomile */
+
 int binbuf_read(t_binbuf *b, const char *filename, const char *dirname, int crflag)
 {
     long length;
@@ -820,6 +1004,7 @@ int binbuf_read(t_binbuf *b, const char *filename, const char *dirname, int crfl
     int readret;
     char *buf;
     char namebuf[MAXPDSTRING];
+    t_binbufcache key; /* camomile */
 
     if (*dirname)
         snprintf(namebuf, MAXPDSTRING-1, "%s/%s", dirname, filename);
@@ -833,6 +1018,15 @@ int binbuf_read(t_binbuf *b, const char *filename, const char *dirname, int crfl
         perror(namebuf);
         return (1);
     }
+/* camomile { */
+    key.c_crflag = crflag;
+    binbuf_cachestat(fd, &key);
+    if (!binbuf_cacheget(b, namebuf, &key))
+    {
+        close(fd);
+        return (0);
+    }
+/* } camomile */
     if ((length = (long)lseek(fd, 0, SEEK_END)) < 0 || lseek(fd, 0, SEEK_SET) < 0
         || !(buf = t_getbytes(length)))
     {
@@ -858,6 +1052,7 @@ int binbuf_read(t_binbuf *b, const char *filename, const char *dirname, int crfl
                 buf[i] = ';';
     }
     binbuf_text(b, buf, length);
+    binbuf_cacheput(b, namebuf, &key); /* camomile */
 
 #if 0
     startpost("binbuf_read "); postatom(b->b_n, b->b_vec); endpost();
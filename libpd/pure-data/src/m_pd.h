@@ -449,6 +449,8 @@ EXTERN int sys_fontheight(int fontsize);
 EXTERN void canvas_dataproperties(t_glist *x, t_scalar *sc, t_binbuf *b);
 EXTERN int canvas_open(const t_canvas *x, const char *name, const char *ext,
     char *dirresult, char **nameresult, unsigned int size, int bin);
+typedef void (*t_canvasopenhook)(const char *dir, const char *name);
+EXTERN void canvas_setopenhook(t_canvasopenhook hook);
 
 /* ---------------- widget behaviors ---------------------- */
 
@@ -693,6 +695,17 @@ EXTERN t_class *garray_class;
 EXTERN int garray_getfloatarray(t_garray *x, int *size, t_float **vec);
 EXTERN int garray_getfloatwords(t_garray *x, int *size, t_word **vec);
 EXTERN void garray_redraw(t_garray *x);
+/* camomile { */
+EXTERN void garray_redrawrange(t_garray *x, int from, int to);
+EXTERN void garray_touchrange(t_garray *x, int from, int to);
+EXTERN int garray_readfloatwords(t_garray *x, int *size, t_word **vec);
+EXTERN unsigned int garray_getchanges(t_garray *x, unsigned int since,
+    int *from, int *to);
+#define GARRAY_SHAREKEY 12  /* number of values that identify a shared vector */
+EXTERN int garray_getshared(int n, t_garray **garrays, const long *key);
+EXTERN void garray_putshared(int n, t_garray **garrays, const long *key);
+EXTERN void garray_dropshared(t_garray *x);
+/* } camomile */
 EXTERN int garray_npoints(t_garray *x);
 EXTERN char *garray_vec(t_garray *x);
 EXTERN void garray_resize(t_garray *x, t_floatarg f);  /* avoid; use this: */
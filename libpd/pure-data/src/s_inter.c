@@ -74,6 +74,9 @@ that didn't really belong anywhere. */
 
 #if PDTHREADS
 #include "pthread.h"
+/* camomile { */
+#include <sched.h>
+/* } camomile */
 #endif
 
 typedef struct _fdpoll
@@ -128,6 +131,10 @@ struct _instanceinter
 #endif
 #if PDTHREADS
     pthread_mutex_t i_mutex;
+/* camomile { */
+    int i_reading;      /* set while the instance is locked, see sys_lock() */
+    int i_writing;      /* set while the instance holds the global lock */
+/* } camomile */
 #endif
 
     unsigned char i_recvbuf[NET_MAXPACKETSIZE];
@@ -1609,6 +1616,8 @@ void s_inter_newpdinstance(void)
 #if PDTHREADS
     pthread_mutex_init(&INTER->i_mutex, NULL);
     pd_this->pd_islocked = 0;
+    INTER->i_reading = 0; /* camomile */
+    INTER->i_writing = 0; /* camomile */
 #endif
 #ifdef _WIN32
     INTER->i_freq = 0;
@@ -1636,7 +1645,69 @@ void s_inter_freepdinstance(void)
 
 #if PDTHREADS
 #ifdef PDINSTANCE
-static pthread_rwlock_t sys_rwlock = PTHREAD_RWLOCK_INITIALIZER;
+/* camomile { */
+    /* The global lock is a big-reader lock.  Locking an instance only sets a
+    flag of the instance and reads the flag of the writer, so the instances
+    that are processed by different threads don't share any written memory.
+    The writer sets its flag and waits until the flags of the other instances
+    are cleared, the instances that are locked meanwhile wait for the writer. */
+static pthread_mutex_t sys_writemutex = PTHREAD_MUTEX_INITIALIZER;
+static int sys_writing;
+
+#ifdef _MSC_VER
+#define sys_atomic_store(p, v) InterlockedExchange((volatile LONG *)(p), (LONG)(v))
+#define sys_atomic_load(p) InterlockedCompareExchange((volatile LONG *)(p), 0, 0)
+#else
+#define sys_atomic_store(p, v) __atomic_store_n((p), (v), __ATOMIC_SEQ_CST)
+#define sys_atomic_load(p) __atomic_load_n((p), __ATOMIC_SEQ_CST)
+#endif
+
+static int sys_tryreadlock(void)
+{
+    sys_atomic_store(&INTER->i_reading, 1);
+    if (!sys_atomic_load(&sys_writing))
+        return (0);
+    sys_atomic_store(&INTER->i_reading, 0);
+    return (EBUSY);
+}
+
+static void sys_readlock(void)
+{
+    while (sys_tryreadlock())
+    {
+        pthread_mutex_lock(&sys_writemutex);
+        pthread_mutex_unlock(&sys_writemutex);
+    }
+}
+
+static void sys_readunlock(void)
+{
+    sys_atomic_store(&INTER->i_reading, 0);
+}
+
+static void sys_writelock(void)
+{
+    int i;
+    pthread_mutex_lock(&sys_writemutex);
+    sys_atomic_store(&sys_writing, 1);
+    for (i = 0; i < pd_ninstances; i++)
+    {
+        if (pd_instances[i] != pd_this)
+        {
+            while (sys_atomic_load(&pd_instances[i]->pd_inter->i_reading))
+                sched_yield();
+        }
+    }
+    INTER->i_writing = 1;
+}
+
+static void sys_writeunlock(void)
+{
+    INTER->i_writing = 0;
+    sys_atomic_store(&sys_writing, 0);
+    pthread_mutex_unlock(&sys_writemutex);
+}
+/* } camomile */
 #else /* PDINSTANCE */
 static pthread_mutex_t sys_mutex = PTHREAD_MUTEX_INITIALIZER;
 #endif /* PDINSTANCE */
@@ -1657,16 +1728,26 @@ void pd_globallock(void)
 #ifdef PDINSTANCE
     if (!pd_this->pd_islocked)
         bug("pd_globallock");
-    pthread_rwlock_unlock(&sys_rwlock);
-    pthread_rwlock_wrlock(&sys_rwlock);
+/* camomile { */
+        /* like the write lock of a rwlock, the global lock isn't counted */
+    if (INTER->i_writing)
+        return;
+    sys_readunlock();
+    sys_writelock();
+/* } camomile */
 #endif /* PDINSTANCE */
 }
 
 void pd_globalunlock(void)
 {
 #ifdef PDINSTANCE
-    pthread_rwlock_unlock(&sys_rwlock);
-    pthread_rwlock_rdlock(&sys_rwlock);
+/* camomile { */
+    if (INTER->i_writing)
+    {
+        sys_writeunlock();
+        sys_readlock();
+    }
+/* } camomile */
 #endif /* PDINSTANCE */
 }
 
@@ -1677,7 +1758,7 @@ void sys_lock(void)
 {
 #ifdef PDINSTANCE
     pthread_mutex_lock(&INTER->i_mutex);
-    pthread_rwlock_rdlock(&sys_rwlock);
+    sys_readlock(); /* camomile */
     pd_this->pd_islocked = 1;
 #else
     pthread_mutex_lock(&sys_mutex);
@@ -1688,7 +1769,13 @@ void sys_unlock(void)
 {
 #ifdef PDINSTANCE
     pd_this->pd_islocked = 0;
-    pthread_rwlock_unlock(&sys_rwlock);
+/* camomile { */
+        /* the global lock can be left by the loader of the externals */
+    if (INTER->i_writing)
+        sys_writeunlock();
+    else
+        sys_readunlock();
+/* } camomile */
     pthread_mutex_unlock(&INTER->i_mutex);
 #else
     pthread_mutex_unlock(&sys_mutex);
@@ -1701,7 +1788,7 @@ int sys_trylock(void)
     int ret;
     if (!(ret = pthread_mutex_trylock(&INTER->i_mutex)))
     {
-        if (!(ret = pthread_rwlock_tryrdlock(&sys_rwlock)))
+        if (!(ret = sys_tryreadlock())) /* camomile */
             return (0);
         else
         {
@@ -408,6 +408,9 @@ struct _instancestuff
     t_sample *st_soundout;
     t_sample *st_soundin;
     double st_time_per_dsp_tick;    /* obsolete - included for GEM?? */
+/* camomile { */
+    unsigned int st_deletions;  /* number of objects deleted from the glists */
+/* } camomile */
 };
 
 #define STUFF (pd_this->pd_stuff)
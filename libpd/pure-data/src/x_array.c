@@ -663,6 +663,13 @@ static void array_set_list(t_array_rangeop *x, t_symbol *s,
 {
     char *itemp, *firstitem;
     int stride, nitem, arrayonset, i;
+    /* camomile { */
+    t_glist *glist;
+    t_array *a = array_client_getbuf(&x->x_tc, &glist);
+    if (!a)
+        return;
+    array_unshare(a);
+    /* } camomile */
     if (!array_rangeop_getrange(x, &firstitem, &nitem, &stride, &arrayonset))
         return;
     if (nitem > argc)
@@ -898,7 +898,7 @@ max_ex_tab(struct expr *expr, fts_symbol_t s, struct ex_ex *arg,
         t_word *wvec;
 
         if (!s || !(garray = (t_garray *)pd_findbyclass(s, garray_class)) ||
-            !garray_getfloatwords(garray, &size, &wvec))
+            !garray_readfloatwords(garray, &size, &wvec)) /* camomile */
         {
                 optr->ex_type = ET_FLT;
                 optr->ex_flt = 0;
@@ -1036,9 +1036,10 @@ max_ex_var(struct expr *expr, t_symbol *var, struct ex_ex *optr, int idx)
 #ifdef PD /* this goes to the end of this file as the following functions
            * should be defined in the expr object in MSP
            */
+/* camomile: the tables are only read, see garray_readfloatwords() */
 #define ISTABLE(sym, garray, size, vec)                               \
 if (!sym || !(garray = (t_garray *)pd_findbyclass(sym, garray_class)) || \
-                !garray_getfloatwords(garray, &size, &vec))  {          \
+                !garray_readfloatwords(garray, &size, &vec))  {         \
         optr->ex_type = ET_FLT;                                         \
         optr->ex_int = 0;                                               \
         pd_error(0, "no such table '%s'", sym?(sym->s_name):"(null)");                       \
@@ -271,14 +271,31 @@ int libpd_resize_array(const char *name, long size) {
 
 int libpd_read_array(float *dest, const char *name, int offset, int n) {
   sys_lock();
-  MEMCPY(*dest++, (vec++)->w_float)
+  /* camomile { */
+  /* the shared vectors are read without being copied */
+  GETARRAY
+  if (n < 0 || offset < 0 || offset + n > garray_npoints(garray)) return -2;
+  t_word *vec;
+  int i;
+  if (!garray_readfloatwords(garray, &i, &vec)) {sys_unlock(); return -1;}
+  for (vec += offset, i = 0; i < n; i++) *dest++ = (vec++)->w_float;
+  /* } camomile */
   sys_unlock();
   return 0;
 }
 
 int libpd_write_array(const char *name, int offset, const float *src, int n) {
   sys_lock();
-  MEMCPY((vec++)->w_float, *src++)
+  /* camomile { */
+  /* garray_vec() doesn't copy the shared vectors before they are written */
+  GETARRAY
+  if (n < 0 || offset < 0 || offset + n > garray_npoints(garray)) return -2;
+  t_word *vec;
+  int i;
+  if (!garray_getfloatwords(garray, &i, &vec)) {sys_unlock(); return -1;}
+  for (vec += offset, i = 0; i < n; i++) (vec++)->w_float = *src++;
+  garray_redrawrange(garray, offset, offset + n);
+  /* } camomile */
   sys_unlock();
   return 0;
 }